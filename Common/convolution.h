@@ -0,0 +1,160 @@
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "fft.h"
+
+// Linear convolution of blocks of a real signal with one FIR kernel through a real transform of a fixed size, the
+// building block of overlap-add filtering. A block of up to GetBlockSize() samples comes out count + kernelSize - 1
+// samples long, with no wrap-around.
+template<typename Real>
+class BasicFIRConvolution {
+    public:
+        BasicFIRConvolution(const std::vector<double>&, const uint32_t&);
+        uint32_t GetTransformSize() const;
+        uint32_t GetBlockSize() const;
+        // output = input * kernel for count <= GetBlockSize() input samples. output gets the transform size; the
+        // samples past count + kernelSize - 1 are zero up to rounding.
+        void Convolve(const Real*, const uint32_t&, std::vector<Real>&);
+    private:
+        const BasicRealFFTPlan<Real>& plan;
+        uint32_t kernelSize;
+        BasicComplexArray<Real> kernelSpectrum;
+        BasicComplexArray<Real> spectrum;
+};
+using FIRConvolution = BasicFIRConvolution<double>;
+template<typename Real>
+BasicFIRConvolution<Real>::BasicFIRConvolution(const std::vector<double>& kernel, const uint32_t& transformSize)
+    : plan(GetSharedRealFFTPlan<Real>(transformSize)), kernelSize(kernel.size()) {
+    if (kernel.empty() || kernel.size() > transformSize)
+        throw std::runtime_error("FIR kernel must be non-empty and fit the transform.");
+    std::vector<Real> paddedKernel(kernel.begin(), kernel.end());
+    paddedKernel.resize(transformSize);
+    plan.Forward(paddedKernel, kernelSpectrum);
+}
+template<typename Real>
+uint32_t BasicFIRConvolution<Real>::GetTransformSize() const {
+    return plan.GetSize();
+}
+template<typename Real>
+uint32_t BasicFIRConvolution<Real>::GetBlockSize() const {
+    return plan.GetSize() - kernelSize + 1;
+}
+template<typename Real>
+void BasicFIRConvolution<Real>::Convolve(const Real* input, const uint32_t& count, std::vector<Real>& output) {
+    if (count > GetBlockSize())
+        throw std::runtime_error("FIR block is longer than the transform allows.");
+    output.resize(plan.GetSize());
+    std::copy(input, input + count, output.begin());
+    std::fill(output.begin() + count, output.end(), Real(0));
+    plan.Forward(output, spectrum);
+    GetSimdKernels<Real>().multiply(spectrum.re.data(), spectrum.im.data(), kernelSpectrum.re.data(),
+                                    kernelSpectrum.im.data(), spectrum.GetSize());
+    plan.Inverse(spectrum, output);
+}
+
+// Exact products of big integers (little-endian arrays of 32-bit words) through the double-precision transform.
+// The operands are cut into chunks of b bits, the chunk sequences are convolved and the rounded coefficients are
+// carried back into words. A coefficient is at most min(n1, n2) (2^b - 1)^2 for n1, n2 chunks, and the transform
+// error grows like 2^2b sqrt(n1 n2) log2(n1 + n2) machine epsilons (times at most 0.6 as measured on all-ones
+// operands, the worst case), so b is the widest that keeps this estimate under 1/8. The rounding distance of every
+// coefficient is checked as well, and a product that comes closer than 1/4 to a tie is redone with narrower chunks
+// rather than returned inexact.
+
+// Number of chunks of the given width in size words.
+uint64_t GetChunkCount(const uint64_t& size, const uint32_t& chunkBits) {
+    return (32 * size + chunkBits - 1) / chunkBits;
+}
+// Widest chunks (at most 16 bits) for which a product of size1 and size2 words stays exact, 0 if there are none.
+uint32_t GetConvolutionChunkBits(const uint32_t& size1, const uint32_t& size2) {
+    for (uint32_t chunkBits = 16; chunkBits > 0; --chunkBits) {
+        uint64_t count1 = GetChunkCount(size1, chunkBits);
+        uint64_t count2 = GetChunkCount(size2, chunkBits);
+        if (count1 + count2 > UINT32_MAX)
+            continue;
+        double error = ldexp(sqrt(static_cast<double>(count1) * count2), 2 * chunkBits - 53)
+                       * log2(static_cast<double>(count1 + count2));
+        if (error < 0.125)
+            return chunkBits;
+    }
+    return 0;
+}
+// chunks[0..n) = the chunkBits-bit pieces of digits, lowest first; the rest of chunks is zeroed.
+void SplitIntoChunks(const uint32_t* digits, const uint32_t& size, const uint32_t& chunkBits, std::vector<double>& chunks) {
+    uint64_t mask = (1ULL << chunkBits) - 1;
+    uint64_t buffer = 0;
+    uint32_t bufferBits = 0;
+    uint32_t word = 0;
+    uint64_t count = GetChunkCount(size, chunkBits);
+    for (uint64_t i = 0; i < count; ++i) {
+        if (bufferBits < chunkBits) {
+            buffer |= static_cast<uint64_t>(word < size ? digits[word] : 0) << bufferBits;
+            bufferBits += 32;
+            ++word;
+        }
+        chunks[i] = buffer & mask;
+        buffer >>= chunkBits;
+        bufferBits -= chunkBits;
+    }
+    std::fill(chunks.begin() + count, chunks.end(), 0.0);
+}
+// One attempt at MultiplyIntegers with the given chunk width; false if some coefficient was not close enough to an
+// integer to be trusted.
+bool MultiplyIntegersWithChunks(uint32_t* result, const uint32_t* digits1, const uint32_t& size1, const uint32_t* digits2,
+                                const uint32_t& size2, const uint32_t& chunkBits) {
+    uint64_t productCount = GetChunkCount(size1, chunkBits) + GetChunkCount(size2, chunkBits);
+    const RealFFTPlan& plan = GetSharedRealFFTPlan<double>(RealFFTPlan::GetFastSize(productCount));
+    bool isSquare = (digits1 == digits2) && (size1 == size2);
+    std::vector<double> values(plan.GetSize());
+    ComplexArray spectrum1;
+    ComplexArray spectrum2;
+    SplitIntoChunks(digits1, size1, chunkBits, values);
+    plan.Forward(values, spectrum1);
+    if (!isSquare) {
+        SplitIntoChunks(digits2, size2, chunkBits, values);
+        plan.Forward(values, spectrum2);
+    }
+    const ComplexArray& factor = (isSquare ? spectrum1 : spectrum2);
+    GetSimdKernels().multiply(spectrum1.re.data(), spectrum1.im.data(), factor.re.data(), factor.im.data(),
+                              spectrum1.GetSize());
+    plan.Inverse(spectrum1, values);
+    // Coefficient i sits at bit i * chunkBits; the carry holds what is not yet written, starting at the current
+    // chunk, and output collects finished bits until they fill a word.
+    uint64_t mask = (1ULL << chunkBits) - 1;
+    uint64_t carry = 0;
+    uint64_t output = 0;
+    uint32_t outputBits = 0;
+    uint32_t word = 0;
+    uint32_t resultSize = size1 + size2;
+    double maxError = 0;
+    for (uint64_t i = 0; word < resultSize; ++i) {
+        if (i < productCount) {
+            double rounded = std::round(values[i]);
+            maxError = std::max(maxError, std::abs(values[i] - rounded));
+            carry += static_cast<uint64_t>(std::max(rounded, 0.0));
+        }
+        output |= (carry & mask) << outputBits;
+        carry >>= chunkBits;
+        outputBits += chunkBits;
+        if (outputBits >= 32) {
+            result[word++] = static_cast<uint32_t>(output);
+            output >>= 32;
+            outputBits -= 32;
+        }
+    }
+    return maxError < 0.25;
+}
+// result (size1 + size2 words, must not overlap the operands) = digits1 * digits2.
+void MultiplyIntegers(uint32_t* result, const uint32_t* digits1, const uint32_t& size1, const uint32_t* digits2,
+                      const uint32_t& size2) {
+    for (uint32_t chunkBits = GetConvolutionChunkBits(size1, size2); chunkBits > 0; --chunkBits)
+        if (MultiplyIntegersWithChunks(result, digits1, size1, digits2, size2, chunkBits))
+            return;
+    throw std::runtime_error("Integer convolution is too long for double precision.");
+}
+
+#endif
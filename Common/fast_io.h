@@ -0,0 +1,302 @@
+#ifndef FAST_IO_H
+#define FAST_IO_H
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Whitespace-separated integers and tokens from a file descriptor, with the failure semantics of std::istream (a
+// failed read sets a flag that operator bool reports and leaves the value alone). A regular file is mapped into
+// memory whole and parsed in place; anything else (pipes, terminals) is read in large blocks.
+class InputReader {
+    public:
+        explicit InputReader(const int& = STDIN_FILENO, const bool& = true);
+        ~InputReader();
+        InputReader(const InputReader&) = delete;
+        InputReader& operator=(const InputReader&) = delete;
+        explicit operator bool() const;
+        // Marks a failed read, for extractors of other types.
+        void SetFailed();
+        // Next byte, or -1 at the end of the input.
+        int Peek();
+        // Skips the current byte and returns the one after it, like std::streambuf::snextc.
+        int Next();
+        // Skips whitespace; false at the end of the input.
+        bool SkipSpace();
+        template<typename Integer>
+        bool ReadInteger(Integer&);
+        bool ReadToken(std::string&);
+        // The next token where it lies in the mapping, valid while the reader lives; false at the end and for input
+        // that is not mapped, which has to go through ReadToken.
+        bool ReadTokenInPlace(const char*&, size_t&);
+        template<typename Integer, typename = typename std::enable_if<std::is_integral<Integer>::value>::type>
+        InputReader& operator>>(Integer&);
+        InputReader& operator>>(std::string&);
+        bool IsMapped() const;
+    private:
+        static const size_t blockSize = 1 << 20;
+        int fileDescriptor;
+        const char* current = nullptr;
+        const char* end = nullptr;
+        char* mapping = nullptr;
+        size_t mappingSize = 0;
+        std::vector<char> block;
+        bool isFailed = false;
+        bool Refill();
+};
+// Buffered output to a file descriptor with hand-rolled integer formatting; everything goes out in large writes, on
+// Flush() and on destruction. Flush() throws if the descriptor refuses the data, the destructor stays silent.
+class OutputWriter {
+    public:
+        explicit OutputWriter(const int& = STDOUT_FILENO);
+        ~OutputWriter();
+        OutputWriter(const OutputWriter&) = delete;
+        OutputWriter& operator=(const OutputWriter&) = delete;
+        void Flush();
+        void Write(const char*, const size_t&);
+        void Write(const char&);
+        template<typename Integer>
+        void WriteInteger(const Integer&);
+        template<typename Integer, typename = typename std::enable_if<std::is_integral<Integer>::value>::type>
+        OutputWriter& operator<<(const Integer&);
+        OutputWriter& operator<<(const bool&);
+        OutputWriter& operator<<(const char&);
+        OutputWriter& operator<<(const char*);
+        OutputWriter& operator<<(const std::string&);
+    private:
+        static const size_t bufferSize = 1 << 20;
+        int fileDescriptor;
+        std::vector<char> buffer;
+        size_t size = 0;
+        void WriteAll(const char*, const size_t&);
+};
+
+// The mapping starts at the page holding the current offset of the descriptor, so input already consumed by
+// someone else is skipped as it would be by read().
+InputReader::InputReader(const int& fileDescriptor, const bool& isMappingAllowed) : fileDescriptor(fileDescriptor) {
+    struct stat status;
+    off_t offset = lseek(fileDescriptor, 0, SEEK_CUR);
+    if (isMappingAllowed && fstat(fileDescriptor, &status) == 0 && S_ISREG(status.st_mode) && offset >= 0
+        && status.st_size > offset) {
+        off_t pageOffset = offset - offset % sysconf(_SC_PAGESIZE);
+        mappingSize = status.st_size - pageOffset;
+        void* address = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fileDescriptor, pageOffset);
+        if (address != MAP_FAILED) {
+            mapping = static_cast<char*>(address);
+            madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+            current = mapping + (offset - pageOffset);
+            end = mapping + mappingSize;
+            lseek(fileDescriptor, 0, SEEK_END);
+            return;
+        }
+        mappingSize = 0;
+    }
+    block.resize(blockSize);
+}
+InputReader::~InputReader() {
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+}
+InputReader::operator bool() const {
+    return !isFailed;
+}
+void InputReader::SetFailed() {
+    isFailed = true;
+}
+bool InputReader::IsMapped() const {
+    return mapping != nullptr;
+}
+bool InputReader::Refill() {
+    if (mapping != nullptr)
+        return false;
+    ssize_t count;
+    do
+        count = read(fileDescriptor, block.data(), block.size());
+    while (count < 0 && errno == EINTR);
+    if (count <= 0)
+        return false;
+    current = block.data();
+    end = current + count;
+    return true;
+}
+int InputReader::Peek() {
+    if (current == end && !Refill())
+        return -1;
+    return static_cast<unsigned char>(*current);
+}
+int InputReader::Next() {
+    if (current == end && !Refill())
+        return -1;
+    ++current;
+    return Peek();
+}
+bool InputReader::SkipSpace() {
+    while (true) {
+        while (current != end && static_cast<unsigned char>(*current) <= ' ')
+            ++current;
+        if (current != end)
+            return true;
+        if (!Refill())
+            return false;
+    }
+}
+// Overflow is not detected, as with the tasks' own parsing before.
+template<typename Integer>
+bool InputReader::ReadInteger(Integer& value) {
+    if (!SkipSpace())
+        return false;
+    bool isNegative = false;
+    if (*current == '-' || *current == '+') {
+        isNegative = *current == '-';
+        if (Next() < 0)
+            return false;
+    }
+    if (*current < '0' || *current > '9')
+        return false;
+    typename std::make_unsigned<Integer>::type magnitude = 0;
+    while (true) {
+        while (current != end && static_cast<unsigned char>(*current - '0') < 10)
+            magnitude = magnitude * 10 + (*current++ - '0');
+        if (current != end || !Refill())
+            break;
+    }
+    value = static_cast<Integer>(isNegative ? 0 - magnitude : magnitude);
+    return true;
+}
+bool InputReader::ReadToken(std::string& token) {
+    token.clear();
+    if (!SkipSpace())
+        return false;
+    while (true) {
+        const char* start = current;
+        while (current != end && static_cast<unsigned char>(*current) > ' ')
+            ++current;
+        token.append(start, current);
+        if (current != end || !Refill())
+            return true;
+    }
+}
+bool InputReader::ReadTokenInPlace(const char*& token, size_t& length) {
+    if (mapping == nullptr || !SkipSpace())
+        return false;
+    token = current;
+    while (current != end && static_cast<unsigned char>(*current) > ' ')
+        ++current;
+    length = current - token;
+    return true;
+}
+template<typename Integer, typename>
+InputReader& InputReader::operator>>(Integer& value) {
+    if (!isFailed && !ReadInteger(value))
+        isFailed = true;
+    return *this;
+}
+InputReader& InputReader::operator>>(std::string& token) {
+    if (!isFailed && !ReadToken(token))
+        isFailed = true;
+    return *this;
+}
+
+OutputWriter::OutputWriter(const int& fileDescriptor) : fileDescriptor(fileDescriptor), buffer(bufferSize) {}
+OutputWriter::~OutputWriter() {
+    try {
+        Flush();
+    } catch (const std::exception&) {}
+}
+void OutputWriter::WriteAll(const char* data, const size_t& count) {
+    for (size_t written = 0; written < count;) {
+        ssize_t chunk = write(fileDescriptor, data + written, count - written);
+        if (chunk < 0 && errno == EINTR)
+            continue;
+        if (chunk <= 0)
+            throw std::runtime_error("Output write failed.");
+        written += chunk;
+    }
+}
+void OutputWriter::Flush() {
+    size_t count = size;
+    size = 0;
+    WriteAll(buffer.data(), count);
+}
+// Data larger than the buffer goes out directly after what is buffered.
+void OutputWriter::Write(const char* data, const size_t& count) {
+    if (size + count > buffer.size()) {
+        Flush();
+        if (count > buffer.size()) {
+            WriteAll(data, count);
+            return;
+        }
+    }
+    std::memcpy(buffer.data() + size, data, count);
+    size += count;
+}
+void OutputWriter::Write(const char& character) {
+    if (size == buffer.size())
+        Flush();
+    buffer[size++] = character;
+}
+// Digits are produced two at a time from a table, right to left into a small scratch array.
+template<typename Integer>
+void OutputWriter::WriteInteger(const Integer& value) {
+    static const char digitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char digits[24];
+    char* start = digits + sizeof(digits);
+    typename std::make_unsigned<Integer>::type magnitude = value;
+    bool isNegative = value < 0;
+    if (isNegative)
+        magnitude = 0 - magnitude;
+    while (magnitude >= 100) {
+        unsigned int pair = magnitude % 100;
+        magnitude /= 100;
+        *--start = digitPairs[2 * pair + 1];
+        *--start = digitPairs[2 * pair];
+    }
+    if (magnitude >= 10) {
+        *--start = digitPairs[2 * magnitude + 1];
+        *--start = digitPairs[2 * magnitude];
+    }
+    else
+        *--start = static_cast<char>('0' + magnitude);
+    if (isNegative)
+        *--start = '-';
+    if (size + sizeof(digits) > buffer.size())
+        Flush();
+    std::memcpy(buffer.data() + size, start, digits + sizeof(digits) - start);
+    size += digits + sizeof(digits) - start;
+}
+template<typename Integer, typename>
+OutputWriter& OutputWriter::operator<<(const Integer& value) {
+    WriteInteger(value);
+    return *this;
+}
+// As 0 or 1, like std::ostream without boolalpha.
+OutputWriter& OutputWriter::operator<<(const bool& value) {
+    Write(value ? '1' : '0');
+    return *this;
+}
+OutputWriter& OutputWriter::operator<<(const char& character) {
+    Write(character);
+    return *this;
+}
+OutputWriter& OutputWriter::operator<<(const char* text) {
+    Write(text, std::strlen(text));
+    return *this;
+}
+OutputWriter& OutputWriter::operator<<(const std::string& text) {
+    Write(text.data(), text.size());
+    return *this;
+}
+
+#endif
@@ -0,0 +1,839 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "simd.h"
+#include "thread_pool.h"
+
+// Split complex buffer: real and imaginary parts in two arrays, the layout the transforms and SIMD kernels use.
+// The transforms below are templates on the element type: float halves the memory traffic and doubles the SIMD
+// width at about 1e-7 relative error, double is the default.
+template<typename Real>
+struct BasicComplexArray {
+    BasicComplexArray() = default;
+    explicit BasicComplexArray(const uint32_t&);
+    std::vector<Real> re;
+    std::vector<Real> im;
+    uint32_t GetSize() const;
+    void Resize(const uint32_t&);
+};
+template<typename Real>
+BasicComplexArray<Real>::BasicComplexArray(const uint32_t& size) : re(size), im(size) {}
+template<typename Real>
+uint32_t BasicComplexArray<Real>::GetSize() const {
+    return re.size();
+}
+template<typename Real>
+void BasicComplexArray<Real>::Resize(const uint32_t& size) {
+    re.resize(size);
+    im.resize(size);
+}
+using ComplexArray = BasicComplexArray<double>;
+
+// Everything an in-place transform of one size needs. Powers of two get the bit-reversal permutation and, for every
+// radix-4 stage, its twiddles stored contiguously. From fourStepThreshold on, and only while the shared ThreadPool
+// exists, the transform is instead split into rows and columns of two smaller plans (the four-step algorithm) that
+// stay in cache and run as independent tasks; on one thread the extra transpositions cost more than they save.
+// Other sizes are factored into radices 4, 2, 3, 5, 7 and whatever primes remain, and run as a mixed-radix
+// Stockham transform, unless a large prime factor makes Bluestein's algorithm (a power-of-two convolution) cheaper.
+// A plan is read-only after construction and can be shared by any number of threads.
+template<typename Real>
+class BasicFFTPlan {
+    public:
+        explicit BasicFFTPlan(const uint32_t&);
+        uint32_t GetSize() const;
+        // X[k] = sum x[j] * exp(-2 pi i j k / size).
+        void Forward(BasicComplexArray<Real>&) const;
+        // x[j] = sum X[k] * exp(2 pi i j k / size) / size.
+        void Inverse(BasicComplexArray<Real>&) const;
+    private:
+        // One pass of the mixed-radix transform: radix subsequences of length span are combined into span blocks of
+        // radix outputs.
+        struct MixedRadixStage {
+            uint32_t radix;
+            uint32_t span;
+            // w^(p k) at (k - 1) * span + p for 1 <= k < radix, p < span, w = exp(-2 pi i / (radix * span)).
+            std::vector<Real> twiddlesRe;
+            std::vector<Real> twiddlesIm;
+            // exp(-2 pi i j / radix) for j < radix; only the generic odd butterfly reads these.
+            std::vector<Real> rootsRe;
+            std::vector<Real> rootsIm;
+            // Large primes are transformed by a plan of their own (Bluestein) instead of a direct DFT.
+            std::unique_ptr<BasicFFTPlan> subPlan;
+        };
+        uint32_t size;
+        std::vector<MixedRadixStage> stages;
+        // Bluestein: with c[n] = exp(-pi i n^2 / size), X = c * (conj(c) conv (c * x)), the convolution taken
+        // cyclically at convolutionPlan's size. chirpSpectrum holds the transform of the conj(c) kernel.
+        std::unique_ptr<BasicFFTPlan> convolutionPlan;
+        BasicComplexArray<Real> chirp;
+        BasicComplexArray<Real> chirpSpectrum;
+        std::vector<uint32_t> bitReversal;
+        // For the stage joining quarters of length q, six arrays of q values: the real and imaginary parts of w^2j,
+        // w^j and w^3j for j < q, w = exp(-2 pi i / (4 q)). This is the layout SimdKernels::radix4Stage reads.
+        std::vector<Real> twiddles;
+        static const uint32_t fourStepThreshold = 1 << 18;
+        // Minimum number of elements one task of a four-step pass works on.
+        static const uint32_t fourStepGrainSize = 1 << 15;
+        // Four-step decomposition size = rowCount * rowPlan size, with rowCount = columnPlan size.
+        std::unique_ptr<BasicFFTPlan> rowPlan;
+        std::unique_ptr<BasicFFTPlan> columnPlan;
+        // exp(-2 pi i m / size) = coarse[m / rowSize] * fine[m % rowSize] for the twiddles between the two passes.
+        BasicComplexArray<Real> coarseTwiddles;
+        BasicComplexArray<Real> fineTwiddles;
+        static std::vector<uint32_t> GetRadices(uint32_t);
+        static bool IsSubPlanRadix(const uint32_t&);
+        static double GetMixedRadixCost(const std::vector<uint32_t>&);
+        static double GetBluesteinCost(const uint32_t&, const uint32_t&);
+        static uint32_t GetConvolutionSize(const uint32_t&);
+        static double GetCost(const uint32_t&);
+        static std::unique_ptr<BasicComplexArray<Real>> TakeBuffer(const uint32_t&);
+        static void ReturnBuffer(std::unique_ptr<BasicComplexArray<Real>>);
+        void Transform(Real*, Real*, const bool&) const;
+        void RadixTransform(Real*, Real*) const;
+        void FourStepTransform(Real*, Real*) const;
+        void MixedRadixTransform(Real*, Real*) const;
+        void RunStage(const MixedRadixStage&, const uint32_t&, const Real*, const Real*, Real*, Real*) const;
+        void RunSubPlanStage(const MixedRadixStage&, const uint32_t&, const Real*, const Real*, Real*, Real*) const;
+        void BluesteinTransform(Real*, Real*) const;
+        template<typename> friend class BasicRealFFTPlan;
+};
+using FFTPlan = BasicFFTPlan<double>;
+template<typename Real>
+BasicFFTPlan<Real>::BasicFFTPlan(const uint32_t& size) : size(size) {
+    if (size == 0)
+        throw std::runtime_error("FFT size must be positive");
+    double pi = acos(-1);
+    if ((size & (size - 1)) != 0) {
+        // Bluestein transforms at least twice the size, it can only win when a large prime factor is left.
+        std::vector<uint32_t> radices = GetRadices(size);
+        uint32_t convolutionSize = (radices.back() > 7 ? GetConvolutionSize(size) : 0);
+        if ((convolutionSize == 0) || (GetMixedRadixCost(radices) <= GetBluesteinCost(size, convolutionSize))) {
+            uint32_t span = size;
+            for (uint32_t radix : radices) {
+                span /= radix;
+                MixedRadixStage stage;
+                stage.radix = radix;
+                stage.span = span;
+                for (uint64_t k = 1; k < radix; ++k)
+                    for (uint64_t p = 0; p < span; ++p) {
+                        double angle = -2 * pi * (p * k % (radix * span)) / (radix * span);
+                        stage.twiddlesRe.push_back(cos(angle));
+                        stage.twiddlesIm.push_back(sin(angle));
+                    }
+                if (IsSubPlanRadix(radix))
+                    stage.subPlan.reset(new BasicFFTPlan(radix));
+                else
+                    for (uint32_t j = 0; j < radix; ++j) {
+                        stage.rootsRe.push_back(cos(-2 * pi * j / radix));
+                        stage.rootsIm.push_back(sin(-2 * pi * j / radix));
+                    }
+                stages.push_back(std::move(stage));
+            }
+            return;
+        }
+        convolutionPlan.reset(new BasicFFTPlan(convolutionSize));
+        chirp.Resize(size);
+        chirpSpectrum.Resize(convolutionSize);
+        for (uint64_t n = 0; n < size; ++n) {
+            // n^2 is reduced modulo 2 size first, the angle only depends on it and stays accurate.
+            double angle = -pi * (n * n % (2 * static_cast<uint64_t>(size))) / size;
+            chirp.re[n] = cos(angle);
+            chirp.im[n] = sin(angle);
+            chirpSpectrum.re[n] = chirp.re[n];
+            chirpSpectrum.im[n] = -chirp.im[n];
+            if (n != 0) {
+                chirpSpectrum.re[convolutionSize - n] = chirp.re[n];
+                chirpSpectrum.im[convolutionSize - n] = -chirp.im[n];
+            }
+        }
+        convolutionPlan->Forward(chirpSpectrum);
+        return;
+    }
+    uint32_t bitCount = 0;
+    while ((1U << bitCount) < size)
+        ++bitCount;
+    if (size >= fourStepThreshold) {
+        uint32_t rowCount = 1U << (bitCount / 2);
+        uint32_t rowSize = size / rowCount;
+        rowPlan.reset(new BasicFFTPlan(rowSize));
+        columnPlan.reset(new BasicFFTPlan(rowCount));
+        coarseTwiddles.Resize(rowCount);
+        for (uint32_t i = 0; i < rowCount; ++i) {
+            coarseTwiddles.re[i] = cos(-2 * pi * i / rowCount);
+            coarseTwiddles.im[i] = sin(-2 * pi * i / rowCount);
+        }
+        fineTwiddles.Resize(rowSize);
+        for (uint32_t i = 0; i < rowSize; ++i) {
+            fineTwiddles.re[i] = cos(-2 * pi * i / size);
+            fineTwiddles.im[i] = sin(-2 * pi * i / size);
+        }
+    }
+    bitReversal.resize(size);
+    for (uint32_t i = 1; i < size; ++i)
+        bitReversal[i] = (bitReversal[i >> 1] >> 1) | ((i & 1) << (bitCount - 1));
+    for (uint32_t quarter = (bitCount % 2 == 0 ? 1 : 2); 4 * quarter <= size; quarter *= 4)
+        for (uint32_t k : {2, 1, 3}) {
+            for (uint32_t j = 0; j < quarter; ++j)
+                twiddles.push_back(cos(-2 * pi * k * j / (4 * quarter)));
+            for (uint32_t j = 0; j < quarter; ++j)
+                twiddles.push_back(sin(-2 * pi * k * j / (4 * quarter)));
+        }
+}
+template<typename Real>
+uint32_t BasicFFTPlan<Real>::GetSize() const {
+    return size;
+}
+template<typename Real>
+void BasicFFTPlan<Real>::Forward(BasicComplexArray<Real>& data) const {
+    Transform(data.re.data(), data.im.data(), false);
+}
+template<typename Real>
+void BasicFFTPlan<Real>::Inverse(BasicComplexArray<Real>& data) const {
+    Transform(data.re.data(), data.im.data(), true);
+}
+// The inverse is the forward transform applied between two conjugations.
+template<typename Real>
+void BasicFFTPlan<Real>::Transform(Real* re, Real* im, const bool& isInverse) const {
+    if (isInverse)
+        for (uint32_t i = 0; i < size; ++i)
+            im[i] = -im[i];
+    if (convolutionPlan)
+        BluesteinTransform(re, im);
+    else if (!stages.empty())
+        MixedRadixTransform(re, im);
+    else if (rowPlan && ThreadPool::GetInstance())
+        FourStepTransform(re, im);
+    else
+        RadixTransform(re, im);
+    if (isInverse) {
+        Real scale = 1.0 / size;
+        for (uint32_t i = 0; i < size; ++i) {
+            re[i] *= scale;
+            im[i] *= -scale;
+        }
+    }
+}
+// Decimation in time after the bit-reversal permutation. Pairs of radix-2 stages are fused into radix-4 butterflies
+// (one radix-2 stage goes first when log2(size) is odd).
+template<typename Real>
+void BasicFFTPlan<Real>::RadixTransform(Real* re, Real* im) const {
+    for (uint32_t i = 0; i < size; ++i)
+        if (i < bitReversal[i]) {
+            std::swap(re[i], re[bitReversal[i]]);
+            std::swap(im[i], im[bitReversal[i]]);
+        }
+    uint32_t quarter = 1;
+    if ((size & 0xAAAAAAAAU) != 0) {
+        for (uint32_t i = 0; i < size; i += 2) {
+            Real uRe = re[i];
+            Real uIm = im[i];
+            re[i] = uRe + re[i + 1];
+            im[i] = uIm + im[i + 1];
+            re[i + 1] = uRe - re[i + 1];
+            im[i + 1] = uIm - im[i + 1];
+        }
+        quarter = 2;
+    }
+    const SimdKernels<Real>& kernels = GetSimdKernels<Real>();
+    const Real* stageTwiddles = twiddles.data();
+    for (; 4 * quarter <= size; stageTwiddles += 6 * quarter, quarter *= 4)
+        kernels.radix4Stage(re, im, size, quarter, stageTwiddles);
+}
+// With size = R * C, n = r + R c and k = k2 + C k1 (r, k1 < R; c, k2 < C):
+// X[k2 + C k1] = sum_r w_R^(r k1) * [w^(r k2) * sum_c x[r + R c] w_C^(c k2)], w = exp(-2 pi i / size).
+// The first pass gathers the R strided subsequences x[r + R c] into rows of a scratch buffer, transforms them and
+// applies the twiddles. The second gathers columns of the scratch buffer into a small tile, transforms them and
+// scatters the result straight to its natural position. Both run tile by tile so the strided side of every
+// transposition touches whole cache lines.
+template<typename Real>
+void BasicFFTPlan<Real>::FourStepTransform(Real* re, Real* im) const {
+    uint32_t rowCount = columnPlan->GetSize();
+    uint32_t rowSize = rowPlan->GetSize();
+    uint32_t rowBits = 0;
+    while ((1U << rowBits) < rowSize)
+        ++rowBits;
+    // Rows of the scratch buffers are padded: at a power-of-two stride the rows of a tile would all map to the same
+    // cache sets.
+    const uint32_t tileSize = 16;
+    uint32_t scratchStride = rowSize + 8;
+    uint32_t tileStride = rowCount + 8;
+    std::unique_ptr<BasicComplexArray<Real>> scratch = TakeBuffer(rowCount * scratchStride);
+    Real* scratchRe = scratch->re.data();
+    Real* scratchIm = scratch->im.data();
+    // Runs task(first, last) over [0, count) in pieces of at least fourStepGrainSize elements of elementsPerItem.
+    auto parallelFor = [](uint32_t count, uint32_t elementsPerItem, const std::function<void(uint32_t, uint32_t)>& task) {
+        uint32_t itemsPerTask = std::max(1U, fourStepGrainSize / elementsPerItem);
+        TaskGroup group;
+        for (uint32_t first = 0; first < count; first += itemsPerTask) {
+            uint32_t last = std::min(count, first + itemsPerTask);
+            group.Run([&task, first, last] { task(first, last); });
+        }
+        group.Wait();
+    };
+    parallelFor(rowCount / tileSize, tileSize * rowSize, [&](uint32_t first, uint32_t last) {
+        for (uint32_t r0 = first * tileSize; r0 < last * tileSize; r0 += tileSize) {
+            for (uint32_t c = 0; c < rowSize; ++c)
+                for (uint32_t r = r0; r < r0 + tileSize; ++r) {
+                    scratchRe[static_cast<size_t>(r) * scratchStride + c] = re[r + static_cast<size_t>(rowCount) * c];
+                    scratchIm[static_cast<size_t>(r) * scratchStride + c] = im[r + static_cast<size_t>(rowCount) * c];
+                }
+            for (uint32_t r = r0; r < r0 + tileSize; ++r) {
+                Real* rowRe = scratchRe + static_cast<size_t>(r) * scratchStride;
+                Real* rowIm = scratchIm + static_cast<size_t>(r) * scratchStride;
+                rowPlan->RadixTransform(rowRe, rowIm);
+                // m = r k2 < size.
+                for (uint32_t k2 = 0, m = 0; k2 < rowSize; ++k2, m += r) {
+                    uint32_t coarse = m >> rowBits;
+                    uint32_t fine = m & (rowSize - 1);
+                    Real wRe = coarseTwiddles.re[coarse] * fineTwiddles.re[fine] - coarseTwiddles.im[coarse] * fineTwiddles.im[fine];
+                    Real wIm = coarseTwiddles.re[coarse] * fineTwiddles.im[fine] + coarseTwiddles.im[coarse] * fineTwiddles.re[fine];
+                    Real valueRe = rowRe[k2];
+                    rowRe[k2] = valueRe * wRe - rowIm[k2] * wIm;
+                    rowIm[k2] = valueRe * wIm + rowIm[k2] * wRe;
+                }
+            }
+        }
+    });
+    parallelFor(rowSize / tileSize, tileSize * rowCount, [&](uint32_t first, uint32_t last) {
+        std::unique_ptr<BasicComplexArray<Real>> tile = TakeBuffer(tileSize * tileStride);
+        Real* tileRe = tile->re.data();
+        Real* tileIm = tile->im.data();
+        for (uint32_t k20 = first * tileSize; k20 < last * tileSize; k20 += tileSize) {
+            for (uint32_t r = 0; r < rowCount; ++r)
+                for (uint32_t k2 = 0; k2 < tileSize; ++k2) {
+                    tileRe[k2 * tileStride + r] = scratchRe[static_cast<size_t>(r) * scratchStride + k20 + k2];
+                    tileIm[k2 * tileStride + r] = scratchIm[static_cast<size_t>(r) * scratchStride + k20 + k2];
+                }
+            for (uint32_t k2 = 0; k2 < tileSize; ++k2)
+                columnPlan->RadixTransform(tileRe + k2 * tileStride, tileIm + k2 * tileStride);
+            for (uint32_t k1 = 0; k1 < rowCount; ++k1)
+                for (uint32_t k2 = 0; k2 < tileSize; ++k2) {
+                    re[static_cast<size_t>(k1) * rowSize + k20 + k2] = tileRe[k2 * tileStride + k1];
+                    im[static_cast<size_t>(k1) * rowSize + k20 + k2] = tileIm[k2 * tileStride + k1];
+                }
+        }
+        ReturnBuffer(std::move(tile));
+    });
+    ReturnBuffer(std::move(scratch));
+}
+
+// Radices 4 first, then 2, 3, 5, 7 and the remaining primes in increasing order.
+template<typename Real>
+std::vector<uint32_t> BasicFFTPlan<Real>::GetRadices(uint32_t size) {
+    std::vector<uint32_t> radices;
+    for (uint32_t radix : {4, 2, 3, 5, 7})
+        while (size % radix == 0) {
+            radices.push_back(radix);
+            size /= radix;
+        }
+    for (uint32_t radix = 11; radix <= size / radix; radix += 2)
+        while (size % radix == 0) {
+            radices.push_back(radix);
+            size /= radix;
+        }
+    if (size > 1)
+        radices.push_back(size);
+    return radices;
+}
+// Whether a prime radix is cheaper through a Bluestein sub-plan (plus gathering and twiddles) than as a direct DFT.
+template<typename Real>
+bool BasicFFTPlan<Real>::IsSubPlanRadix(const uint32_t& radix) {
+    return (radix > 7) && (GetBluesteinCost(radix, GetConvolutionSize(radix)) + 10 < 2.0 * radix + 8);
+}
+// Rough floating-point operations per element: butterfly plus twiddles for every stage. A generic radix-r butterfly
+// is a direct r-point DFT, so large prime factors go to a sub-plan instead.
+template<typename Real>
+double BasicFFTPlan<Real>::GetMixedRadixCost(const std::vector<uint32_t>& radices) {
+    if (radices.empty())
+        return 0;
+    double cost = 0;
+    for (uint32_t radix : radices) {
+        if (radix == 2)
+            cost += 5;
+        else if (radix == 3)
+            cost += 9.3;
+        else if (radix == 4)
+            cost += 8.5;
+        else if (radix == 5)
+            cost += 14.4;
+        else if (IsSubPlanRadix(radix))
+            cost += GetBluesteinCost(radix, GetConvolutionSize(radix)) + 10;
+        else
+            cost += 2.0 * radix + 8;
+    }
+    return cost;
+}
+// The same per-element measure for Bluestein: two transforms of convolutionSize and three pointwise products.
+template<typename Real>
+double BasicFFTPlan<Real>::GetBluesteinCost(const uint32_t& size, const uint32_t& convolutionSize) {
+    double transformCost = GetMixedRadixCost(GetRadices(convolutionSize));
+    return (2 * transformCost * convolutionSize + 6.0 * convolutionSize + 12.0 * size) / size;
+}
+// The cheapest size of the form 2^a 3^b 5^c 7^d that holds the 2 size - 1 terms of the Bluestein convolution; only
+// candidates below the next power of two can beat it.
+template<typename Real>
+uint32_t BasicFFTPlan<Real>::GetConvolutionSize(const uint32_t& size) {
+    uint64_t minimalSize = 2 * static_cast<uint64_t>(size) - 1;
+    uint64_t twoPower = 1;
+    while (twoPower < minimalSize)
+        twoPower *= 2;
+    uint32_t bestSize = twoPower;
+    double bestCost = GetBluesteinCost(size, twoPower);
+    for (uint64_t power7 = 1; power7 < twoPower; power7 *= 7)
+        for (uint64_t power5 = power7; power5 < twoPower; power5 *= 5)
+            for (uint64_t power3 = power5; power3 < twoPower; power3 *= 3) {
+                uint64_t candidate = power3;
+                while (candidate < minimalSize)
+                    candidate *= 2;
+                double cost = GetBluesteinCost(size, candidate);
+                if ((candidate < twoPower) && (cost < bestCost)) {
+                    bestSize = candidate;
+                    bestCost = cost;
+                }
+            }
+    return bestSize;
+}
+// Estimated operations of a whole transform with the plan the constructor would choose.
+template<typename Real>
+double BasicFFTPlan<Real>::GetCost(const uint32_t& size) {
+    if (size <= 1)
+        return 0;
+    std::vector<uint32_t> radices = GetRadices(size);
+    double cost = GetMixedRadixCost(radices);
+    if (radices.back() > 7)
+        cost = std::min(cost, GetBluesteinCost(size, GetConvolutionSize(size)));
+    return cost * size;
+}
+// Scratch buffers are recycled per thread; a thread can start another transform while waiting for this one's tasks.
+template<typename Real>
+std::vector<std::unique_ptr<BasicComplexArray<Real>>>& GetFreeFFTBuffers() {
+    static thread_local std::vector<std::unique_ptr<BasicComplexArray<Real>>> freeBuffers;
+    return freeBuffers;
+}
+// A buffer of at least the given size, with arbitrary contents.
+template<typename Real>
+std::unique_ptr<BasicComplexArray<Real>> BasicFFTPlan<Real>::TakeBuffer(const uint32_t& bufferSize) {
+    std::vector<std::unique_ptr<BasicComplexArray<Real>>>& freeBuffers = GetFreeFFTBuffers<Real>();
+    std::unique_ptr<BasicComplexArray<Real>> buffer(freeBuffers.empty() ? new BasicComplexArray<Real>()
+                                                                         : freeBuffers.back().release());
+    if (!freeBuffers.empty())
+        freeBuffers.pop_back();
+    if (buffer->GetSize() < bufferSize)
+        buffer->Resize(bufferSize);
+    return buffer;
+}
+template<typename Real>
+void BasicFFTPlan<Real>::ReturnBuffer(std::unique_ptr<BasicComplexArray<Real>> buffer) {
+    GetFreeFFTBuffers<Real>().push_back(std::move(buffer));
+}
+// Stockham autosort decimation in frequency: every stage reads one buffer and writes the other, and the last one
+// leaves the spectrum in natural order, so there is no digit-reversal permutation.
+template<typename Real>
+void BasicFFTPlan<Real>::MixedRadixTransform(Real* re, Real* im) const {
+    std::unique_ptr<BasicComplexArray<Real>> scratch = TakeBuffer(size);
+    Real* fromRe = re;
+    Real* fromIm = im;
+    Real* toRe = scratch->re.data();
+    Real* toIm = scratch->im.data();
+    uint32_t stride = 1;
+    for (const MixedRadixStage& stage : stages) {
+        if (stage.subPlan)
+            RunSubPlanStage(stage, stride, fromRe, fromIm, toRe, toIm);
+        else
+            RunStage(stage, stride, fromRe, fromIm, toRe, toIm);
+        std::swap(fromRe, toRe);
+        std::swap(fromIm, toIm);
+        stride *= stage.radix;
+    }
+    if (fromRe != re) {
+        std::copy(fromRe, fromRe + size, re);
+        std::copy(fromIm, fromIm + size, im);
+    }
+    ReturnBuffer(std::move(scratch));
+}
+// With n = radix * span and s = stride: for p < span and q < s, the inputs a[j] = x[q + s (p + j span)] give
+// y[q + s (radix p + k)] = w^(p k) * sum_j a[j] exp(-2 pi i j k / radix). The loop over q is innermost and
+// contiguous, so the late stages, where s is large, vectorize.
+template<typename Real>
+void BasicFFTPlan<Real>::RunStage(const MixedRadixStage& stage, const uint32_t& stride, const Real* xRe,
+                                  const Real* xIm, Real* yRe, Real* yIm) const {
+    uint32_t radix = stage.radix;
+    uint32_t span = stage.span;
+    size_t inputStep = static_cast<size_t>(stride) * span;
+    auto twiddle = [&stage, span](uint32_t k, uint32_t p, Real& valueRe, Real& valueIm) {
+        Real wRe = stage.twiddlesRe[(k - 1) * span + p];
+        Real wIm = stage.twiddlesIm[(k - 1) * span + p];
+        Real copyRe = valueRe;
+        valueRe = copyRe * wRe - valueIm * wIm;
+        valueIm = copyRe * wIm + valueIm * wRe;
+    };
+    for (uint32_t p = 0; p < span; ++p) {
+        const Real* aRe = xRe + static_cast<size_t>(stride) * p;
+        const Real* aIm = xIm + static_cast<size_t>(stride) * p;
+        Real* bRe = yRe + static_cast<size_t>(stride) * radix * p;
+        Real* bIm = yIm + static_cast<size_t>(stride) * radix * p;
+        if (radix == 2) {
+            for (uint32_t q = 0; q < stride; ++q) {
+                Real a0Re = aRe[q], a0Im = aIm[q];
+                Real a1Re = aRe[q + inputStep], a1Im = aIm[q + inputStep];
+                Real dRe = a0Re - a1Re, dIm = a0Im - a1Im;
+                twiddle(1, p, dRe, dIm);
+                bRe[q] = a0Re + a1Re;
+                bIm[q] = a0Im + a1Im;
+                bRe[q + stride] = dRe;
+                bIm[q + stride] = dIm;
+            }
+        }
+        else if (radix == 3) {
+            // exp(-2 pi i / 3) = -1/2 - i sqrt(3)/2.
+            const Real sin60 = 0.86602540378443864676;
+            for (uint32_t q = 0; q < stride; ++q) {
+                Real a0Re = aRe[q], a0Im = aIm[q];
+                Real sumRe = aRe[q + inputStep] + aRe[q + 2 * inputStep];
+                Real sumIm = aIm[q + inputStep] + aIm[q + 2 * inputStep];
+                Real diffRe = aRe[q + inputStep] - aRe[q + 2 * inputStep];
+                Real diffIm = aIm[q + inputStep] - aIm[q + 2 * inputStep];
+                Real midRe = a0Re - sumRe / 2, midIm = a0Im - sumIm / 2;
+                Real y1Re = midRe + sin60 * diffIm, y1Im = midIm - sin60 * diffRe;
+                Real y2Re = midRe - sin60 * diffIm, y2Im = midIm + sin60 * diffRe;
+                twiddle(1, p, y1Re, y1Im);
+                twiddle(2, p, y2Re, y2Im);
+                bRe[q] = a0Re + sumRe;
+                bIm[q] = a0Im + sumIm;
+                bRe[q + stride] = y1Re;
+                bIm[q + stride] = y1Im;
+                bRe[q + 2 * stride] = y2Re;
+                bIm[q + 2 * stride] = y2Im;
+            }
+        }
+        else if (radix == 4) {
+            for (uint32_t q = 0; q < stride; ++q) {
+                Real t0Re = aRe[q] + aRe[q + 2 * inputStep], t0Im = aIm[q] + aIm[q + 2 * inputStep];
+                Real t1Re = aRe[q] - aRe[q + 2 * inputStep], t1Im = aIm[q] - aIm[q + 2 * inputStep];
+                Real t2Re = aRe[q + inputStep] + aRe[q + 3 * inputStep];
+                Real t2Im = aIm[q + inputStep] + aIm[q + 3 * inputStep];
+                Real t3Re = aRe[q + inputStep] - aRe[q + 3 * inputStep];
+                Real t3Im = aIm[q + inputStep] - aIm[q + 3 * inputStep];
+                // y1 = t1 - i t3, y3 = t1 + i t3.
+                Real y1Re = t1Re + t3Im, y1Im = t1Im - t3Re;
+                Real y2Re = t0Re - t2Re, y2Im = t0Im - t2Im;
+                Real y3Re = t1Re - t3Im, y3Im = t1Im + t3Re;
+                twiddle(1, p, y1Re, y1Im);
+                twiddle(2, p, y2Re, y2Im);
+                twiddle(3, p, y3Re, y3Im);
+                bRe[q] = t0Re + t2Re;
+                bIm[q] = t0Im + t2Im;
+                bRe[q + stride] = y1Re;
+                bIm[q + stride] = y1Im;
+                bRe[q + 2 * stride] = y2Re;
+                bIm[q + 2 * stride] = y2Im;
+                bRe[q + 3 * stride] = y3Re;
+                bIm[q + 3 * stride] = y3Im;
+            }
+        }
+        else if (radix == 5) {
+            // cos and sin of 2 pi / 5 and 4 pi / 5.
+            const Real c1 = 0.30901699437494742410, c2 = -0.80901699437494742410;
+            const Real s1 = 0.95105651629515357212, s2 = 0.58778525229247312917;
+            for (uint32_t q = 0; q < stride; ++q) {
+                Real a0Re = aRe[q], a0Im = aIm[q];
+                Real b1Re = aRe[q + inputStep] + aRe[q + 4 * inputStep];
+                Real b1Im = aIm[q + inputStep] + aIm[q + 4 * inputStep];
+                Real b2Re = aRe[q + 2 * inputStep] + aRe[q + 3 * inputStep];
+                Real b2Im = aIm[q + 2 * inputStep] + aIm[q + 3 * inputStep];
+                Real d1Re = aRe[q + inputStep] - aRe[q + 4 * inputStep];
+                Real d1Im = aIm[q + inputStep] - aIm[q + 4 * inputStep];
+                Real d2Re = aRe[q + 2 * inputStep] - aRe[q + 3 * inputStep];
+                Real d2Im = aIm[q + 2 * inputStep] - aIm[q + 3 * inputStep];
+                Real m1Re = a0Re + c1 * b1Re + c2 * b2Re, m1Im = a0Im + c1 * b1Im + c2 * b2Im;
+                Real m2Re = a0Re + c2 * b1Re + c1 * b2Re, m2Im = a0Im + c2 * b1Im + c1 * b2Im;
+                // y1, y4 = m1 -+ i (s1 d1 + s2 d2); y2, y3 = m2 -+ i (s2 d1 - s1 d2).
+                Real e1Re = s1 * d1Re + s2 * d2Re, e1Im = s1 * d1Im + s2 * d2Im;
+                Real e2Re = s2 * d1Re - s1 * d2Re, e2Im = s2 * d1Im - s1 * d2Im;
+                Real y1Re = m1Re + e1Im, y1Im = m1Im - e1Re;
+                Real y4Re = m1Re - e1Im, y4Im = m1Im + e1Re;
+                Real y2Re = m2Re + e2Im, y2Im = m2Im - e2Re;
+                Real y3Re = m2Re - e2Im, y3Im = m2Im + e2Re;
+                twiddle(1, p, y1Re, y1Im);
+                twiddle(2, p, y2Re, y2Im);
+                twiddle(3, p, y3Re, y3Im);
+                twiddle(4, p, y4Re, y4Im);
+                bRe[q] = a0Re + b1Re + b2Re;
+                bIm[q] = a0Im + b1Im + b2Im;
+                bRe[q + stride] = y1Re;
+                bIm[q + stride] = y1Im;
+                bRe[q + 2 * stride] = y2Re;
+                bIm[q + 2 * stride] = y2Im;
+                bRe[q + 3 * stride] = y3Re;
+                bIm[q + 3 * stride] = y3Im;
+                bRe[q + 4 * stride] = y4Re;
+                bIm[q + 4 * stride] = y4Im;
+            }
+        }
+        else {
+            // Odd radix: with b[j] = a[j] + a[radix - j] and d[j] = a[j] - a[radix - j] for 1 <= j <= radix / 2,
+            // y[k], y[radix - k] = a[0] + sum_j cos(2 pi j k / radix) b[j] -+ i sum_j sin(2 pi j k / radix) d[j].
+            uint32_t half = radix / 2;
+            for (uint32_t q = 0; q < stride; ++q) {
+                Real a0Re = aRe[q], a0Im = aIm[q];
+                Real y0Re = a0Re, y0Im = a0Im;
+                for (uint32_t j = 1; j <= half; ++j) {
+                    y0Re += aRe[q + j * inputStep] + aRe[q + (radix - j) * inputStep];
+                    y0Im += aIm[q + j * inputStep] + aIm[q + (radix - j) * inputStep];
+                }
+                bRe[q] = y0Re;
+                bIm[q] = y0Im;
+                for (uint32_t k = 1; k <= half; ++k) {
+                    Real mRe = a0Re, mIm = a0Im, eRe = 0, eIm = 0;
+                    for (uint32_t j = 1, root = k; j <= half; ++j, root = (root + k) % radix) {
+                        Real cosine = stage.rootsRe[root];
+                        Real sine = -stage.rootsIm[root];
+                        const Real* upRe = aRe + q + j * inputStep;
+                        const Real* upIm = aIm + q + j * inputStep;
+                        const Real* downRe = aRe + q + (radix - j) * inputStep;
+                        const Real* downIm = aIm + q + (radix - j) * inputStep;
+                        mRe += cosine * (*upRe + *downRe);
+                        mIm += cosine * (*upIm + *downIm);
+                        eRe += sine * (*upRe - *downRe);
+                        eIm += sine * (*upIm - *downIm);
+                    }
+                    Real yRe = mRe + eIm, yIm = mIm - eRe;
+                    Real mirrorRe = mRe - eIm, mirrorIm = mIm + eRe;
+                    twiddle(k, p, yRe, yIm);
+                    twiddle(radix - k, p, mirrorRe, mirrorIm);
+                    bRe[q + k * stride] = yRe;
+                    bIm[q + k * stride] = yIm;
+                    bRe[q + (radix - k) * stride] = mirrorRe;
+                    bIm[q + (radix - k) * stride] = mirrorIm;
+                }
+            }
+        }
+    }
+}
+// The same stage with the radix-point DFT of every (p, q) gathered into a buffer and handed to the sub-plan.
+template<typename Real>
+void BasicFFTPlan<Real>::RunSubPlanStage(const MixedRadixStage& stage, const uint32_t& stride, const Real* xRe,
+                                         const Real* xIm, Real* yRe, Real* yIm) const {
+    uint32_t radix = stage.radix;
+    uint32_t span = stage.span;
+    size_t inputStep = static_cast<size_t>(stride) * span;
+    std::unique_ptr<BasicComplexArray<Real>> buffer = TakeBuffer(radix);
+    Real* bufferRe = buffer->re.data();
+    Real* bufferIm = buffer->im.data();
+    for (uint32_t p = 0; p < span; ++p)
+        for (uint32_t q = 0; q < stride; ++q) {
+            size_t input = q + static_cast<size_t>(stride) * p;
+            for (uint32_t j = 0; j < radix; ++j) {
+                bufferRe[j] = xRe[input + j * inputStep];
+                bufferIm[j] = xIm[input + j * inputStep];
+            }
+            stage.subPlan->Transform(bufferRe, bufferIm, false);
+            size_t output = q + static_cast<size_t>(stride) * radix * p;
+            yRe[output] = bufferRe[0];
+            yIm[output] = bufferIm[0];
+            for (uint32_t k = 1; k < radix; ++k) {
+                Real wRe = stage.twiddlesRe[(k - 1) * span + p];
+                Real wIm = stage.twiddlesIm[(k - 1) * span + p];
+                yRe[output + k * stride] = bufferRe[k] * wRe - bufferIm[k] * wIm;
+                yIm[output + k * stride] = bufferRe[k] * wIm + bufferIm[k] * wRe;
+            }
+        }
+    ReturnBuffer(std::move(buffer));
+}
+// X[k] = c[k] sum_n (x[n] c[n]) conj(c[k - n]), since 2 n k = n^2 + k^2 - (k - n)^2. The product with the
+// conjugated chirp is a cyclic convolution as long as its size is at least 2 size - 1.
+template<typename Real>
+void BasicFFTPlan<Real>::BluesteinTransform(Real* re, Real* im) const {
+    uint32_t convolutionSize = convolutionPlan->GetSize();
+    std::unique_ptr<BasicComplexArray<Real>> buffer = TakeBuffer(convolutionSize);
+    Real* bufferRe = buffer->re.data();
+    Real* bufferIm = buffer->im.data();
+    for (uint32_t n = 0; n < size; ++n) {
+        bufferRe[n] = re[n] * chirp.re[n] - im[n] * chirp.im[n];
+        bufferIm[n] = re[n] * chirp.im[n] + im[n] * chirp.re[n];
+    }
+    std::fill(bufferRe + size, bufferRe + convolutionSize, Real(0));
+    std::fill(bufferIm + size, bufferIm + convolutionSize, Real(0));
+    convolutionPlan->Transform(bufferRe, bufferIm, false);
+    const SimdKernels<Real>& kernels = GetSimdKernels<Real>();
+    kernels.multiply(bufferRe, bufferIm, chirpSpectrum.re.data(), chirpSpectrum.im.data(), convolutionSize);
+    convolutionPlan->Transform(bufferRe, bufferIm, true);
+    for (uint32_t k = 0; k < size; ++k) {
+        re[k] = bufferRe[k] * chirp.re[k] - bufferIm[k] * chirp.im[k];
+        im[k] = bufferRe[k] * chirp.im[k] + bufferIm[k] * chirp.re[k];
+    }
+    ReturnBuffer(std::move(buffer));
+}
+
+// Transform of real input of any size (at least 2). For even sizes the even and odd samples are packed as the real
+// and imaginary parts of one complex sequence of half the size, and a twiddle pass separates the two spectra; odd
+// sizes go through a complex transform of the full size. Only bins 0..size/2 are stored, the rest are their
+// conjugates.
+template<typename Real>
+class BasicRealFFTPlan {
+    public:
+        explicit BasicRealFFTPlan(const uint32_t&);
+        // The size of at least the given one (and 2) whose plan is estimated to be the cheapest: the size itself
+        // when it has only small prime factors, otherwise usually a slightly larger one of the form 2^a 3^b 5^c 7^d.
+        static uint32_t GetFastSize(const uint32_t&);
+        uint32_t GetSize() const;
+        // Fills spectrum with X[0..size/2] of the input, which must hold size samples.
+        void Forward(const std::vector<Real>&, BasicComplexArray<Real>&) const;
+        // Inverse of Forward; the spectrum is used as scratch space and does not survive the call.
+        void Inverse(BasicComplexArray<Real>&, std::vector<Real>&) const;
+    private:
+        uint32_t size;
+        // Of size / 2 points for even sizes and size points for odd ones.
+        BasicFFTPlan<Real> complexPlan;
+        // w^k for k <= size / 4, w = exp(-2 pi i / size); even sizes only.
+        std::vector<Real> twiddlesRe;
+        std::vector<Real> twiddlesIm;
+};
+using RealFFTPlan = BasicRealFFTPlan<double>;
+template<typename Real>
+BasicRealFFTPlan<Real>::BasicRealFFTPlan(const uint32_t& size)
+    : size(size), complexPlan(size % 2 == 0 ? size / 2 : size) {
+    double pi = acos(-1);
+    for (uint32_t k = 0; (size % 2 == 0) && (k <= size / 4); ++k) {
+        twiddlesRe.push_back(cos(-2 * pi * k / size));
+        twiddlesIm.push_back(sin(-2 * pi * k / size));
+    }
+}
+template<typename Real>
+uint32_t BasicRealFFTPlan<Real>::GetFastSize(const uint32_t& minimalSize) {
+    auto getCost = [](uint64_t size) {
+        if (size % 2 == 0)
+            return BasicFFTPlan<Real>::GetCost(size / 2) + 5.0 * size;
+        return BasicFFTPlan<Real>::GetCost(size);
+    };
+    uint64_t size = std::max(2U, minimalSize);
+    // The weights of radices 3, 5 and 7 are pessimistic next to the SIMD radix-4 kernels; such sizes are kept.
+    if (BasicFFTPlan<Real>::GetRadices(size).back() <= 7)
+        return size;
+    uint64_t twoPower = 2;
+    while (twoPower < size)
+        twoPower *= 2;
+    uint32_t bestSize = size;
+    double bestCost = getCost(size);
+    for (uint64_t power7 = 1; power7 <= twoPower; power7 *= 7)
+        for (uint64_t power5 = power7; power5 <= twoPower; power5 *= 5)
+            for (uint64_t power3 = power5; power3 <= twoPower; power3 *= 3) {
+                uint64_t candidate = power3;
+                while (candidate < size)
+                    candidate *= 2;
+                double cost = getCost(candidate);
+                if ((candidate <= twoPower) && (cost < bestCost)) {
+                    bestSize = candidate;
+                    bestCost = cost;
+                }
+            }
+    return bestSize;
+}
+template<typename Real>
+uint32_t BasicRealFFTPlan<Real>::GetSize() const {
+    return size;
+}
+template<typename Real>
+void BasicRealFFTPlan<Real>::Forward(const std::vector<Real>& input, BasicComplexArray<Real>& spectrum) const {
+    uint32_t half = size / 2;
+    if (size % 2 != 0) {
+        spectrum.Resize(size);
+        std::copy(input.begin(), input.begin() + size, spectrum.re.begin());
+        std::fill(spectrum.im.begin(), spectrum.im.end(), Real(0));
+        complexPlan.Transform(spectrum.re.data(), spectrum.im.data(), false);
+        spectrum.Resize(half + 1);
+        return;
+    }
+    spectrum.Resize(half + 1);
+    Real* re = spectrum.re.data();
+    Real* im = spectrum.im.data();
+    for (uint32_t j = 0; j < half; ++j) {
+        re[j] = input[2 * j];
+        im[j] = input[2 * j + 1];
+    }
+    complexPlan.Transform(re, im, false);
+    // With Z = FFT(even + i odd): E[k] = (Z[k] + conj(Z[half - k])) / 2, O[k] = (Z[k] - conj(Z[half - k])) / 2i,
+    // and X[k] = E[k] + w^k O[k], X[half - k] = conj(E[k] - w^k O[k]).
+    Real z0Re = re[0];
+    Real z0Im = im[0];
+    re[0] = z0Re + z0Im;
+    im[0] = 0;
+    re[half] = z0Re - z0Im;
+    im[half] = 0;
+    for (uint32_t k = 1; 2 * k <= half; ++k) {
+        Real evenRe = (re[k] + re[half - k]) / 2;
+        Real evenIm = (im[k] - im[half - k]) / 2;
+        Real oRe = (im[k] + im[half - k]) / 2;
+        Real oIm = (re[half - k] - re[k]) / 2;
+        Real oddRe = oRe * twiddlesRe[k] - oIm * twiddlesIm[k];
+        Real oddIm = oRe * twiddlesIm[k] + oIm * twiddlesRe[k];
+        re[k] = evenRe + oddRe;
+        im[k] = evenIm + oddIm;
+        re[half - k] = evenRe - oddRe;
+        im[half - k] = oddIm - evenIm;
+    }
+}
+template<typename Real>
+void BasicRealFFTPlan<Real>::Inverse(BasicComplexArray<Real>& spectrum, std::vector<Real>& output) const {
+    uint32_t half = size / 2;
+    output.resize(size);
+    if (size % 2 != 0) {
+        spectrum.Resize(size);
+        spectrum.im[0] = 0;
+        for (uint32_t k = half + 1; k < size; ++k) {
+            spectrum.re[k] = spectrum.re[size - k];
+            spectrum.im[k] = -spectrum.im[size - k];
+        }
+        complexPlan.Transform(spectrum.re.data(), spectrum.im.data(), true);
+        std::copy(spectrum.re.begin(), spectrum.re.end(), output.begin());
+        return;
+    }
+    Real* re = spectrum.re.data();
+    Real* im = spectrum.im.data();
+    // The same separation run backwards: E[k] = (X[k] + conj(X[half - k])) / 2, O[k] = (X[k] - conj(X[half - k])) / 2w^k,
+    // and Z[k] = E[k] + i O[k] is the spectrum of even + i odd.
+    Real x0Re = re[0];
+    Real xHalfRe = re[half];
+    re[0] = (x0Re + xHalfRe) / 2;
+    im[0] = (x0Re - xHalfRe) / 2;
+    for (uint32_t k = 1; 2 * k <= half; ++k) {
+        Real evenRe = (re[k] + re[half - k]) / 2;
+        Real evenIm = (im[k] - im[half - k]) / 2;
+        Real oRe = (re[k] - re[half - k]) / 2;
+        Real oIm = (im[k] + im[half - k]) / 2;
+        Real oddRe = oRe * twiddlesRe[k] + oIm * twiddlesIm[k];
+        Real oddIm = oIm * twiddlesRe[k] - oRe * twiddlesIm[k];
+        re[k] = evenRe - oddIm;
+        im[k] = evenIm + oddRe;
+        re[half - k] = evenRe + oddIm;
+        im[half - k] = oddRe - evenIm;
+    }
+    complexPlan.Transform(re, im, true);
+    for (uint32_t j = 0; j < half; ++j) {
+        output[2 * j] = re[j];
+        output[2 * j + 1] = im[j];
+    }
+}
+
+// Plans are built once per size and then only read, so every user of a size can share one; they live as long as the
+// process.
+template<typename Real>
+const BasicRealFFTPlan<Real>& GetSharedRealFFTPlan(const uint32_t& size) {
+    static std::mutex mutex;
+    static std::map<uint32_t, std::unique_ptr<BasicRealFFTPlan<Real>>> plans;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<BasicRealFFTPlan<Real>>& plan = plans[size];
+    if (!plan)
+        plan.reset(new BasicRealFFTPlan<Real>(size));
+    return *plan;
+}
+
+#endif
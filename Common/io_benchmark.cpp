@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "fast_io.h"
+
+// Throughput of the task binaries' input and output paths on a large text file of signed integers, two per line
+// like the edge lists of Task_3_1. The file is written twice (through std::ofstream and through OutputWriter, with
+// the same numbers) and then read back three times; the file is normally still in the page cache by then, so the
+// reads measure parsing rather than the disk.
+
+// Deterministic pseudo-random numbers of mixed lengths, cheap enough not to hide the formatting cost.
+class NumberSequence {
+    public:
+        int64_t GetNext() {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            int64_t value = static_cast<int64_t>(state >> (state % 48 + 16));
+            return (state & 1 ? -value : value);
+        }
+    private:
+        uint64_t state = 88172645463325252ULL;
+};
+
+struct Measurement {
+    std::string method;
+    double seconds = 0;
+    int64_t checksum = 0;
+};
+
+// Writes about size bytes of numbers through write(value, isLineEnd), 9 bytes per number on average; the checksum
+// is their sum.
+Measurement MeasureWrite(const std::string& method, const uint64_t& size,
+                         const std::function<void(const int64_t&, const bool&)>& write,
+                         const std::function<void()>& finish) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    NumberSequence numbers;
+    Measurement measurement;
+    measurement.method = method;
+    for (uint64_t count = 0, total = size / 9 & ~1ULL; count < total; ++count) {
+        int64_t value = numbers.GetNext();
+        measurement.checksum += value;
+        write(value, count % 2 == 1);
+    }
+    finish();
+    measurement.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return measurement;
+}
+Measurement MeasureRead(const std::string& method, const std::function<int64_t()>& read) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Measurement measurement;
+    measurement.method = method;
+    measurement.checksum = read();
+    measurement.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return measurement;
+}
+
+int32_t main(int32_t argc, char** argv) {
+    try {
+        std::vector<std::string> arguments(argv + 1, argv + argc);
+        uint64_t sizeInMegabytes = 2048;
+        bool isKept = false;
+        std::vector<std::string> paths;
+        for (size_t index = 0; index < arguments.size(); ++index) {
+            std::string option = arguments[index];
+            if (option == "--size" && index + 1 < arguments.size())
+                sizeInMegabytes = std::stoull(arguments[++index]);
+            else if (option == "--keep")
+                isKept = true;
+            else if (option.compare(0, 2, "--") == 0)
+                throw std::runtime_error("Unknown option " + option + ".");
+            else
+                paths.push_back(option);
+        }
+        if (paths.size() > 1) {
+            std::cerr << "Usage: " << argv[0] << " [--size MB] [--keep] [file]" << std::endl;
+            return 1;
+        }
+        std::string path = (paths.empty() ? "io_benchmark.txt" : paths[0]);
+        uint64_t size = sizeInMegabytes << 20;
+        std::vector<Measurement> measurements;
+        {
+            std::ofstream output(path);
+            measurements.push_back(MeasureWrite("std::ofstream <<", size,
+                [&](const int64_t& value, const bool& isLineEnd) { output << value << (isLineEnd ? '\n' : ' '); },
+                [&]() { output.close(); }));
+        }
+        {
+            int fileDescriptor = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fileDescriptor < 0)
+                throw std::runtime_error("Cannot create " + path + ".");
+            OutputWriter writer(fileDescriptor);
+            measurements.push_back(MeasureWrite("OutputWriter", size,
+                [&](const int64_t& value, const bool& isLineEnd) { writer << value << (isLineEnd ? '\n' : ' '); },
+                [&]() { writer.Flush(); close(fileDescriptor); }));
+        }
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        uint64_t fileSize = file.tellg();
+        file.close();
+        measurements.push_back(MeasureRead("std::ifstream >>", [&]() {
+            std::ifstream input(path);
+            int64_t sum = 0;
+            for (int64_t value; input >> value;)
+                sum += value;
+            return sum;
+        }));
+        for (bool isMappingAllowed : {false, true})
+            measurements.push_back(MeasureRead(isMappingAllowed ? "InputReader mmap" : "InputReader read", [&]() {
+                int fileDescriptor = open(path.c_str(), O_RDONLY);
+                if (fileDescriptor < 0)
+                    throw std::runtime_error("Cannot open " + path + ".");
+                int64_t sum = 0;
+                {
+                    InputReader reader(fileDescriptor, isMappingAllowed);
+                    for (int64_t value; reader >> value;)
+                        sum += value;
+                }
+                close(fileDescriptor);
+                return sum;
+            }));
+        if (!isKept)
+            std::remove(path.c_str());
+        std::cout << "file " << fileSize / 1e6 << " MB" << std::endl
+                  << "method                 seconds      MB/s  checksum" << std::endl;
+        bool isConsistent = true;
+        for (const Measurement& measurement : measurements) {
+            std::cout << std::left << std::setw(20) << measurement.method << std::right << std::fixed
+                      << std::setprecision(3) << std::setw(10) << measurement.seconds << std::setprecision(1)
+                      << std::setw(10) << fileSize / 1e6 / measurement.seconds << "  "
+                      << (measurement.checksum == measurements[0].checksum ? "ok" : "MISMATCH") << std::endl;
+            isConsistent = isConsistent && measurement.checksum == measurements[0].checksum;
+        }
+        return (isConsistent ? 0 : 1);
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,547 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_X86
+#endif
+
+// Kernels over split (structure-of-arrays) complex data and PCM buffers, each in a scalar, an SSE2 and an AVX2/FMA
+// version and for double and float data; float fits twice as many lanes in a register. The widest version the CPU
+// supports is picked at run time, so the binary itself needs no -mavx2.
+enum SimdLevel {
+    scalarLevel,
+    sseLevel,
+    avxLevel
+};
+
+template<typename Real>
+struct SimdKernels {
+    SimdLevel level;
+    // One radix-4 decimation-in-time stage over re/im of the given size, joining quarters of length quarter.
+    // twiddles holds w^2j, w^j and w^3j for j < quarter as six arrays (re, im) of quarter values each.
+    void (*radix4Stage)(Real*, Real*, uint32_t, uint32_t, const Real*);
+    // (re, im) *= (otherRe, otherIm), elementwise.
+    void (*multiply)(Real*, Real*, const Real*, const Real*, uint32_t);
+    // Scales by the factor, rounds half away from zero like std::round and saturates to the int16 range.
+    void (*toInt16)(const Real*, int16_t*, uint32_t, Real);
+    // Converts and scales by the factor.
+    void (*fromInt16)(const int16_t*, Real*, uint32_t, Real);
+};
+
+template<typename Real>
+void Radix4StageScalar(Real* re, Real* im, uint32_t size, uint32_t quarter, const Real* twiddles) {
+    const Real* w2Re = twiddles;
+    const Real* w2Im = twiddles + quarter;
+    const Real* w1Re = twiddles + 2 * quarter;
+    const Real* w1Im = twiddles + 3 * quarter;
+    const Real* w3Re = twiddles + 4 * quarter;
+    const Real* w3Im = twiddles + 5 * quarter;
+    for (uint32_t block = 0; block < size; block += 4 * quarter)
+        for (uint32_t j = 0; j < quarter; ++j) {
+            Real* xRe = re + block + j;
+            Real* xIm = im + block + j;
+            Real t0Re = xRe[0];
+            Real t0Im = xIm[0];
+            Real t1Re = xRe[quarter] * w2Re[j] - xIm[quarter] * w2Im[j];
+            Real t1Im = xRe[quarter] * w2Im[j] + xIm[quarter] * w2Re[j];
+            Real t2Re = xRe[2 * quarter] * w1Re[j] - xIm[2 * quarter] * w1Im[j];
+            Real t2Im = xRe[2 * quarter] * w1Im[j] + xIm[2 * quarter] * w1Re[j];
+            Real t3Re = xRe[3 * quarter] * w3Re[j] - xIm[3 * quarter] * w3Im[j];
+            Real t3Im = xRe[3 * quarter] * w3Im[j] + xIm[3 * quarter] * w3Re[j];
+            Real sum01Re = t0Re + t1Re;
+            Real sum01Im = t0Im + t1Im;
+            Real difference01Re = t0Re - t1Re;
+            Real difference01Im = t0Im - t1Im;
+            Real sum23Re = t2Re + t3Re;
+            Real sum23Im = t2Im + t3Im;
+            // -i * (t2 - t3)
+            Real rotated23Re = t2Im - t3Im;
+            Real rotated23Im = t3Re - t2Re;
+            xRe[0] = sum01Re + sum23Re;
+            xIm[0] = sum01Im + sum23Im;
+            xRe[quarter] = difference01Re + rotated23Re;
+            xIm[quarter] = difference01Im + rotated23Im;
+            xRe[2 * quarter] = sum01Re - sum23Re;
+            xIm[2 * quarter] = sum01Im - sum23Im;
+            xRe[3 * quarter] = difference01Re - rotated23Re;
+            xIm[3 * quarter] = difference01Im - rotated23Im;
+        }
+}
+template<typename Real>
+void MultiplyScalar(Real* re, Real* im, const Real* otherRe, const Real* otherIm, uint32_t size) {
+    for (uint32_t i = 0; i < size; ++i) {
+        Real productRe = re[i] * otherRe[i] - im[i] * otherIm[i];
+        im[i] = re[i] * otherIm[i] + im[i] * otherRe[i];
+        re[i] = productRe;
+    }
+}
+template<typename Real>
+void ToInt16Scalar(const Real* input, int16_t* output, uint32_t size, Real factor) {
+    for (uint32_t i = 0; i < size; ++i)
+        output[i] = std::max<Real>(-32768, std::min<Real>(32767, std::round(input[i] * factor)));
+}
+template<typename Real>
+void FromInt16Scalar(const int16_t* input, Real* output, uint32_t size, Real factor) {
+    for (uint32_t i = 0; i < size; ++i)
+        output[i] = input[i] * factor;
+}
+
+#ifdef SIMD_X86
+// Vector bodies handle the multiple-of-width part of every range and leave the remainder to the scalar kernels.
+
+void Radix4StageSSE(double* re, double* im, uint32_t size, uint32_t quarter, const double* twiddles) {
+    if (quarter < 2) {
+        Radix4StageScalar(re, im, size, quarter, twiddles);
+        return;
+    }
+    const double* w2Re = twiddles;
+    const double* w2Im = twiddles + quarter;
+    const double* w1Re = twiddles + 2 * quarter;
+    const double* w1Im = twiddles + 3 * quarter;
+    const double* w3Re = twiddles + 4 * quarter;
+    const double* w3Im = twiddles + 5 * quarter;
+    for (uint32_t block = 0; block < size; block += 4 * quarter)
+        for (uint32_t j = 0; j < quarter; j += 2) {
+            double* xRe = re + block + j;
+            double* xIm = im + block + j;
+            __m128d t0Re = _mm_loadu_pd(xRe);
+            __m128d t0Im = _mm_loadu_pd(xIm);
+            __m128d x1Re = _mm_loadu_pd(xRe + quarter);
+            __m128d x1Im = _mm_loadu_pd(xIm + quarter);
+            __m128d x2Re = _mm_loadu_pd(xRe + 2 * quarter);
+            __m128d x2Im = _mm_loadu_pd(xIm + 2 * quarter);
+            __m128d x3Re = _mm_loadu_pd(xRe + 3 * quarter);
+            __m128d x3Im = _mm_loadu_pd(xIm + 3 * quarter);
+            __m128d wRe = _mm_loadu_pd(w2Re + j);
+            __m128d wIm = _mm_loadu_pd(w2Im + j);
+            __m128d t1Re = _mm_sub_pd(_mm_mul_pd(x1Re, wRe), _mm_mul_pd(x1Im, wIm));
+            __m128d t1Im = _mm_add_pd(_mm_mul_pd(x1Re, wIm), _mm_mul_pd(x1Im, wRe));
+            wRe = _mm_loadu_pd(w1Re + j);
+            wIm = _mm_loadu_pd(w1Im + j);
+            __m128d t2Re = _mm_sub_pd(_mm_mul_pd(x2Re, wRe), _mm_mul_pd(x2Im, wIm));
+            __m128d t2Im = _mm_add_pd(_mm_mul_pd(x2Re, wIm), _mm_mul_pd(x2Im, wRe));
+            wRe = _mm_loadu_pd(w3Re + j);
+            wIm = _mm_loadu_pd(w3Im + j);
+            __m128d t3Re = _mm_sub_pd(_mm_mul_pd(x3Re, wRe), _mm_mul_pd(x3Im, wIm));
+            __m128d t3Im = _mm_add_pd(_mm_mul_pd(x3Re, wIm), _mm_mul_pd(x3Im, wRe));
+            __m128d sum01Re = _mm_add_pd(t0Re, t1Re);
+            __m128d sum01Im = _mm_add_pd(t0Im, t1Im);
+            __m128d difference01Re = _mm_sub_pd(t0Re, t1Re);
+            __m128d difference01Im = _mm_sub_pd(t0Im, t1Im);
+            __m128d sum23Re = _mm_add_pd(t2Re, t3Re);
+            __m128d sum23Im = _mm_add_pd(t2Im, t3Im);
+            __m128d rotated23Re = _mm_sub_pd(t2Im, t3Im);
+            __m128d rotated23Im = _mm_sub_pd(t3Re, t2Re);
+            _mm_storeu_pd(xRe, _mm_add_pd(sum01Re, sum23Re));
+            _mm_storeu_pd(xIm, _mm_add_pd(sum01Im, sum23Im));
+            _mm_storeu_pd(xRe + quarter, _mm_add_pd(difference01Re, rotated23Re));
+            _mm_storeu_pd(xIm + quarter, _mm_add_pd(difference01Im, rotated23Im));
+            _mm_storeu_pd(xRe + 2 * quarter, _mm_sub_pd(sum01Re, sum23Re));
+            _mm_storeu_pd(xIm + 2 * quarter, _mm_sub_pd(sum01Im, sum23Im));
+            _mm_storeu_pd(xRe + 3 * quarter, _mm_sub_pd(difference01Re, rotated23Re));
+            _mm_storeu_pd(xIm + 3 * quarter, _mm_sub_pd(difference01Im, rotated23Im));
+        }
+}
+void MultiplySSE(double* re, double* im, const double* otherRe, const double* otherIm, uint32_t size) {
+    uint32_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128d aRe = _mm_loadu_pd(re + i);
+        __m128d aIm = _mm_loadu_pd(im + i);
+        __m128d bRe = _mm_loadu_pd(otherRe + i);
+        __m128d bIm = _mm_loadu_pd(otherIm + i);
+        _mm_storeu_pd(re + i, _mm_sub_pd(_mm_mul_pd(aRe, bRe), _mm_mul_pd(aIm, bIm)));
+        _mm_storeu_pd(im + i, _mm_add_pd(_mm_mul_pd(aRe, bIm), _mm_mul_pd(aIm, bRe)));
+    }
+    MultiplyScalar(re + i, im + i, otherRe + i, otherIm + i, size - i);
+}
+// SSE2 has no rounding instruction: values are clamped first, so that adding and subtracting 2^52 rounds them to
+// nearest even, and ties are then moved away from zero.
+void ToInt16SSE(const double* input, int16_t* output, uint32_t size, double factor) {
+    uint32_t i = 0;
+    __m128d scale = _mm_set1_pd(factor);
+    __m128d low = _mm_set1_pd(-32768.0);
+    __m128d high = _mm_set1_pd(32767.0);
+    __m128d magic = _mm_set1_pd(4503599627370496.0);
+    __m128d half = _mm_set1_pd(0.5);
+    __m128d signMask = _mm_set1_pd(-0.0);
+    for (; i + 4 <= size; i += 4) {
+        __m128i packed[2];
+        for (uint32_t k = 0; k < 2; ++k) {
+            __m128d value = _mm_min_pd(high, _mm_max_pd(low, _mm_mul_pd(_mm_loadu_pd(input + i + 2 * k), scale)));
+            __m128d sign = _mm_and_pd(value, signMask);
+            __m128d magnitude = _mm_andnot_pd(signMask, value);
+            __m128d rounded = _mm_sub_pd(_mm_add_pd(magnitude, magic), magic);
+            // Ties went to even; a tie rounded down must go up instead.
+            __m128d isTieDown = _mm_cmpeq_pd(_mm_sub_pd(magnitude, rounded), half);
+            rounded = _mm_add_pd(rounded, _mm_and_pd(isTieDown, _mm_set1_pd(1.0)));
+            rounded = _mm_min_pd(_mm_or_pd(rounded, sign), high);
+            packed[k] = _mm_cvttpd_epi32(rounded);
+        }
+        __m128i words = _mm_unpacklo_epi64(packed[0], packed[1]);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(words, words));
+    }
+    ToInt16Scalar(input + i, output + i, size - i, factor);
+}
+void FromInt16SSE(const int16_t* input, double* output, uint32_t size, double factor) {
+    uint32_t i = 0;
+    __m128d scale = _mm_set1_pd(factor);
+    for (; i + 4 <= size; i += 4) {
+        __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i));
+        __m128i integers = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+        _mm_storeu_pd(output + i, _mm_mul_pd(_mm_cvtepi32_pd(integers), scale));
+        _mm_storeu_pd(output + i + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(integers, integers)), scale));
+    }
+    FromInt16Scalar(input + i, output + i, size - i, factor);
+}
+
+void Radix4StageSSE(float* re, float* im, uint32_t size, uint32_t quarter, const float* twiddles) {
+    if (quarter < 4) {
+        Radix4StageScalar(re, im, size, quarter, twiddles);
+        return;
+    }
+    const float* w2Re = twiddles;
+    const float* w2Im = twiddles + quarter;
+    const float* w1Re = twiddles + 2 * quarter;
+    const float* w1Im = twiddles + 3 * quarter;
+    const float* w3Re = twiddles + 4 * quarter;
+    const float* w3Im = twiddles + 5 * quarter;
+    for (uint32_t block = 0; block < size; block += 4 * quarter)
+        for (uint32_t j = 0; j < quarter; j += 4) {
+            float* xRe = re + block + j;
+            float* xIm = im + block + j;
+            __m128 t0Re = _mm_loadu_ps(xRe);
+            __m128 t0Im = _mm_loadu_ps(xIm);
+            __m128 x1Re = _mm_loadu_ps(xRe + quarter);
+            __m128 x1Im = _mm_loadu_ps(xIm + quarter);
+            __m128 x2Re = _mm_loadu_ps(xRe + 2 * quarter);
+            __m128 x2Im = _mm_loadu_ps(xIm + 2 * quarter);
+            __m128 x3Re = _mm_loadu_ps(xRe + 3 * quarter);
+            __m128 x3Im = _mm_loadu_ps(xIm + 3 * quarter);
+            __m128 wRe = _mm_loadu_ps(w2Re + j);
+            __m128 wIm = _mm_loadu_ps(w2Im + j);
+            __m128 t1Re = _mm_sub_ps(_mm_mul_ps(x1Re, wRe), _mm_mul_ps(x1Im, wIm));
+            __m128 t1Im = _mm_add_ps(_mm_mul_ps(x1Re, wIm), _mm_mul_ps(x1Im, wRe));
+            wRe = _mm_loadu_ps(w1Re + j);
+            wIm = _mm_loadu_ps(w1Im + j);
+            __m128 t2Re = _mm_sub_ps(_mm_mul_ps(x2Re, wRe), _mm_mul_ps(x2Im, wIm));
+            __m128 t2Im = _mm_add_ps(_mm_mul_ps(x2Re, wIm), _mm_mul_ps(x2Im, wRe));
+            wRe = _mm_loadu_ps(w3Re + j);
+            wIm = _mm_loadu_ps(w3Im + j);
+            __m128 t3Re = _mm_sub_ps(_mm_mul_ps(x3Re, wRe), _mm_mul_ps(x3Im, wIm));
+            __m128 t3Im = _mm_add_ps(_mm_mul_ps(x3Re, wIm), _mm_mul_ps(x3Im, wRe));
+            __m128 sum01Re = _mm_add_ps(t0Re, t1Re);
+            __m128 sum01Im = _mm_add_ps(t0Im, t1Im);
+            __m128 difference01Re = _mm_sub_ps(t0Re, t1Re);
+            __m128 difference01Im = _mm_sub_ps(t0Im, t1Im);
+            __m128 sum23Re = _mm_add_ps(t2Re, t3Re);
+            __m128 sum23Im = _mm_add_ps(t2Im, t3Im);
+            __m128 rotated23Re = _mm_sub_ps(t2Im, t3Im);
+            __m128 rotated23Im = _mm_sub_ps(t3Re, t2Re);
+            _mm_storeu_ps(xRe, _mm_add_ps(sum01Re, sum23Re));
+            _mm_storeu_ps(xIm, _mm_add_ps(sum01Im, sum23Im));
+            _mm_storeu_ps(xRe + quarter, _mm_add_ps(difference01Re, rotated23Re));
+            _mm_storeu_ps(xIm + quarter, _mm_add_ps(difference01Im, rotated23Im));
+            _mm_storeu_ps(xRe + 2 * quarter, _mm_sub_ps(sum01Re, sum23Re));
+            _mm_storeu_ps(xIm + 2 * quarter, _mm_sub_ps(sum01Im, sum23Im));
+            _mm_storeu_ps(xRe + 3 * quarter, _mm_sub_ps(difference01Re, rotated23Re));
+            _mm_storeu_ps(xIm + 3 * quarter, _mm_sub_ps(difference01Im, rotated23Im));
+        }
+}
+void MultiplySSE(float* re, float* im, const float* otherRe, const float* otherIm, uint32_t size) {
+    uint32_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128 aRe = _mm_loadu_ps(re + i);
+        __m128 aIm = _mm_loadu_ps(im + i);
+        __m128 bRe = _mm_loadu_ps(otherRe + i);
+        __m128 bIm = _mm_loadu_ps(otherIm + i);
+        _mm_storeu_ps(re + i, _mm_sub_ps(_mm_mul_ps(aRe, bRe), _mm_mul_ps(aIm, bIm)));
+        _mm_storeu_ps(im + i, _mm_add_ps(_mm_mul_ps(aRe, bIm), _mm_mul_ps(aIm, bRe)));
+    }
+    MultiplyScalar(re + i, im + i, otherRe + i, otherIm + i, size - i);
+}
+// The double trick with 2^23: exact for |value| < 2^23, which covers the clamped range.
+void ToInt16SSE(const float* input, int16_t* output, uint32_t size, float factor) {
+    uint32_t i = 0;
+    __m128 scale = _mm_set1_ps(factor);
+    __m128 low = _mm_set1_ps(-32768.0f);
+    __m128 high = _mm_set1_ps(32767.0f);
+    __m128 magic = _mm_set1_ps(8388608.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 signMask = _mm_set1_ps(-0.0f);
+    for (; i + 8 <= size; i += 8) {
+        __m128i packed[2];
+        for (uint32_t k = 0; k < 2; ++k) {
+            __m128 value = _mm_min_ps(high, _mm_max_ps(low, _mm_mul_ps(_mm_loadu_ps(input + i + 4 * k), scale)));
+            __m128 sign = _mm_and_ps(value, signMask);
+            __m128 magnitude = _mm_andnot_ps(signMask, value);
+            __m128 rounded = _mm_sub_ps(_mm_add_ps(magnitude, magic), magic);
+            __m128 isTieDown = _mm_cmpeq_ps(_mm_sub_ps(magnitude, rounded), half);
+            rounded = _mm_add_ps(rounded, _mm_and_ps(isTieDown, _mm_set1_ps(1.0f)));
+            rounded = _mm_min_ps(_mm_or_ps(rounded, sign), high);
+            packed[k] = _mm_cvttps_epi32(rounded);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(packed[0], packed[1]));
+    }
+    ToInt16Scalar(input + i, output + i, size - i, factor);
+}
+void FromInt16SSE(const int16_t* input, float* output, uint32_t size, float factor) {
+    uint32_t i = 0;
+    __m128 scale = _mm_set1_ps(factor);
+    for (; i + 8 <= size; i += 8) {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16);
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+    FromInt16Scalar(input + i, output + i, size - i, factor);
+}
+
+__attribute__((target("avx2,fma")))
+void Radix4StageAVX(double* re, double* im, uint32_t size, uint32_t quarter, const double* twiddles) {
+    if (quarter < 4) {
+        Radix4StageSSE(re, im, size, quarter, twiddles);
+        return;
+    }
+    const double* w2Re = twiddles;
+    const double* w2Im = twiddles + quarter;
+    const double* w1Re = twiddles + 2 * quarter;
+    const double* w1Im = twiddles + 3 * quarter;
+    const double* w3Re = twiddles + 4 * quarter;
+    const double* w3Im = twiddles + 5 * quarter;
+    for (uint32_t block = 0; block < size; block += 4 * quarter)
+        for (uint32_t j = 0; j < quarter; j += 4) {
+            double* xRe = re + block + j;
+            double* xIm = im + block + j;
+            __m256d t0Re = _mm256_loadu_pd(xRe);
+            __m256d t0Im = _mm256_loadu_pd(xIm);
+            __m256d x1Re = _mm256_loadu_pd(xRe + quarter);
+            __m256d x1Im = _mm256_loadu_pd(xIm + quarter);
+            __m256d x2Re = _mm256_loadu_pd(xRe + 2 * quarter);
+            __m256d x2Im = _mm256_loadu_pd(xIm + 2 * quarter);
+            __m256d x3Re = _mm256_loadu_pd(xRe + 3 * quarter);
+            __m256d x3Im = _mm256_loadu_pd(xIm + 3 * quarter);
+            __m256d wRe = _mm256_loadu_pd(w2Re + j);
+            __m256d wIm = _mm256_loadu_pd(w2Im + j);
+            __m256d t1Re = _mm256_fmsub_pd(x1Re, wRe, _mm256_mul_pd(x1Im, wIm));
+            __m256d t1Im = _mm256_fmadd_pd(x1Re, wIm, _mm256_mul_pd(x1Im, wRe));
+            wRe = _mm256_loadu_pd(w1Re + j);
+            wIm = _mm256_loadu_pd(w1Im + j);
+            __m256d t2Re = _mm256_fmsub_pd(x2Re, wRe, _mm256_mul_pd(x2Im, wIm));
+            __m256d t2Im = _mm256_fmadd_pd(x2Re, wIm, _mm256_mul_pd(x2Im, wRe));
+            wRe = _mm256_loadu_pd(w3Re + j);
+            wIm = _mm256_loadu_pd(w3Im + j);
+            __m256d t3Re = _mm256_fmsub_pd(x3Re, wRe, _mm256_mul_pd(x3Im, wIm));
+            __m256d t3Im = _mm256_fmadd_pd(x3Re, wIm, _mm256_mul_pd(x3Im, wRe));
+            __m256d sum01Re = _mm256_add_pd(t0Re, t1Re);
+            __m256d sum01Im = _mm256_add_pd(t0Im, t1Im);
+            __m256d difference01Re = _mm256_sub_pd(t0Re, t1Re);
+            __m256d difference01Im = _mm256_sub_pd(t0Im, t1Im);
+            __m256d sum23Re = _mm256_add_pd(t2Re, t3Re);
+            __m256d sum23Im = _mm256_add_pd(t2Im, t3Im);
+            __m256d rotated23Re = _mm256_sub_pd(t2Im, t3Im);
+            __m256d rotated23Im = _mm256_sub_pd(t3Re, t2Re);
+            _mm256_storeu_pd(xRe, _mm256_add_pd(sum01Re, sum23Re));
+            _mm256_storeu_pd(xIm, _mm256_add_pd(sum01Im, sum23Im));
+            _mm256_storeu_pd(xRe + quarter, _mm256_add_pd(difference01Re, rotated23Re));
+            _mm256_storeu_pd(xIm + quarter, _mm256_add_pd(difference01Im, rotated23Im));
+            _mm256_storeu_pd(xRe + 2 * quarter, _mm256_sub_pd(sum01Re, sum23Re));
+            _mm256_storeu_pd(xIm + 2 * quarter, _mm256_sub_pd(sum01Im, sum23Im));
+            _mm256_storeu_pd(xRe + 3 * quarter, _mm256_sub_pd(difference01Re, rotated23Re));
+            _mm256_storeu_pd(xIm + 3 * quarter, _mm256_sub_pd(difference01Im, rotated23Im));
+        }
+}
+__attribute__((target("avx2,fma")))
+void MultiplyAVX(double* re, double* im, const double* otherRe, const double* otherIm, uint32_t size) {
+    uint32_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256d aRe = _mm256_loadu_pd(re + i);
+        __m256d aIm = _mm256_loadu_pd(im + i);
+        __m256d bRe = _mm256_loadu_pd(otherRe + i);
+        __m256d bIm = _mm256_loadu_pd(otherIm + i);
+        _mm256_storeu_pd(re + i, _mm256_fmsub_pd(aRe, bRe, _mm256_mul_pd(aIm, bIm)));
+        _mm256_storeu_pd(im + i, _mm256_fmadd_pd(aRe, bIm, _mm256_mul_pd(aIm, bRe)));
+    }
+    MultiplyScalar(re + i, im + i, otherRe + i, otherIm + i, size - i);
+}
+// Truncates, then adds the sign wherever the dropped fraction is at least one half: exactly std::round.
+__attribute__((target("avx2,fma")))
+void ToInt16AVX(const double* input, int16_t* output, uint32_t size, double factor) {
+    uint32_t i = 0;
+    __m256d scale = _mm256_set1_pd(factor);
+    __m256d low = _mm256_set1_pd(-32768.0);
+    __m256d high = _mm256_set1_pd(32767.0);
+    __m256d half = _mm256_set1_pd(0.5);
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d signMask = _mm256_set1_pd(-0.0);
+    for (; i + 8 <= size; i += 8) {
+        __m128i packed[2];
+        for (uint32_t k = 0; k < 2; ++k) {
+            __m256d value = _mm256_mul_pd(_mm256_loadu_pd(input + i + 4 * k), scale);
+            __m256d truncated = _mm256_round_pd(value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+            __m256d fraction = _mm256_andnot_pd(signMask, _mm256_sub_pd(value, truncated));
+            __m256d step = _mm256_or_pd(_mm256_and_pd(value, signMask), one);
+            __m256d rounded = _mm256_add_pd(truncated, _mm256_and_pd(_mm256_cmp_pd(fraction, half, _CMP_GE_OQ), step));
+            packed[k] = _mm256_cvtpd_epi32(_mm256_min_pd(high, _mm256_max_pd(low, rounded)));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi32(packed[0], packed[1]));
+    }
+    ToInt16Scalar(input + i, output + i, size - i, factor);
+}
+__attribute__((target("avx2,fma")))
+void FromInt16AVX(const int16_t* input, double* output, uint32_t size, double factor) {
+    uint32_t i = 0;
+    __m256d scale = _mm256_set1_pd(factor);
+    for (; i + 8 <= size; i += 8) {
+        __m256i integers = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+        _mm256_storeu_pd(output + i, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(integers)), scale));
+        _mm256_storeu_pd(output + i + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(integers, 1)), scale));
+    }
+    FromInt16Scalar(input + i, output + i, size - i, factor);
+}
+__attribute__((target("avx2,fma")))
+void Radix4StageAVX(float* re, float* im, uint32_t size, uint32_t quarter, const float* twiddles) {
+    if (quarter < 8) {
+        Radix4StageSSE(re, im, size, quarter, twiddles);
+        return;
+    }
+    const float* w2Re = twiddles;
+    const float* w2Im = twiddles + quarter;
+    const float* w1Re = twiddles + 2 * quarter;
+    const float* w1Im = twiddles + 3 * quarter;
+    const float* w3Re = twiddles + 4 * quarter;
+    const float* w3Im = twiddles + 5 * quarter;
+    for (uint32_t block = 0; block < size; block += 4 * quarter)
+        for (uint32_t j = 0; j < quarter; j += 8) {
+            float* xRe = re + block + j;
+            float* xIm = im + block + j;
+            __m256 t0Re = _mm256_loadu_ps(xRe);
+            __m256 t0Im = _mm256_loadu_ps(xIm);
+            __m256 x1Re = _mm256_loadu_ps(xRe + quarter);
+            __m256 x1Im = _mm256_loadu_ps(xIm + quarter);
+            __m256 x2Re = _mm256_loadu_ps(xRe + 2 * quarter);
+            __m256 x2Im = _mm256_loadu_ps(xIm + 2 * quarter);
+            __m256 x3Re = _mm256_loadu_ps(xRe + 3 * quarter);
+            __m256 x3Im = _mm256_loadu_ps(xIm + 3 * quarter);
+            __m256 wRe = _mm256_loadu_ps(w2Re + j);
+            __m256 wIm = _mm256_loadu_ps(w2Im + j);
+            __m256 t1Re = _mm256_fmsub_ps(x1Re, wRe, _mm256_mul_ps(x1Im, wIm));
+            __m256 t1Im = _mm256_fmadd_ps(x1Re, wIm, _mm256_mul_ps(x1Im, wRe));
+            wRe = _mm256_loadu_ps(w1Re + j);
+            wIm = _mm256_loadu_ps(w1Im + j);
+            __m256 t2Re = _mm256_fmsub_ps(x2Re, wRe, _mm256_mul_ps(x2Im, wIm));
+            __m256 t2Im = _mm256_fmadd_ps(x2Re, wIm, _mm256_mul_ps(x2Im, wRe));
+            wRe = _mm256_loadu_ps(w3Re + j);
+            wIm = _mm256_loadu_ps(w3Im + j);
+            __m256 t3Re = _mm256_fmsub_ps(x3Re, wRe, _mm256_mul_ps(x3Im, wIm));
+            __m256 t3Im = _mm256_fmadd_ps(x3Re, wIm, _mm256_mul_ps(x3Im, wRe));
+            __m256 sum01Re = _mm256_add_ps(t0Re, t1Re);
+            __m256 sum01Im = _mm256_add_ps(t0Im, t1Im);
+            __m256 difference01Re = _mm256_sub_ps(t0Re, t1Re);
+            __m256 difference01Im = _mm256_sub_ps(t0Im, t1Im);
+            __m256 sum23Re = _mm256_add_ps(t2Re, t3Re);
+            __m256 sum23Im = _mm256_add_ps(t2Im, t3Im);
+            __m256 rotated23Re = _mm256_sub_ps(t2Im, t3Im);
+            __m256 rotated23Im = _mm256_sub_ps(t3Re, t2Re);
+            _mm256_storeu_ps(xRe, _mm256_add_ps(sum01Re, sum23Re));
+            _mm256_storeu_ps(xIm, _mm256_add_ps(sum01Im, sum23Im));
+            _mm256_storeu_ps(xRe + quarter, _mm256_add_ps(difference01Re, rotated23Re));
+            _mm256_storeu_ps(xIm + quarter, _mm256_add_ps(difference01Im, rotated23Im));
+            _mm256_storeu_ps(xRe + 2 * quarter, _mm256_sub_ps(sum01Re, sum23Re));
+            _mm256_storeu_ps(xIm + 2 * quarter, _mm256_sub_ps(sum01Im, sum23Im));
+            _mm256_storeu_ps(xRe + 3 * quarter, _mm256_sub_ps(difference01Re, rotated23Re));
+            _mm256_storeu_ps(xIm + 3 * quarter, _mm256_sub_ps(difference01Im, rotated23Im));
+        }
+}
+__attribute__((target("avx2,fma")))
+void MultiplyAVX(float* re, float* im, const float* otherRe, const float* otherIm, uint32_t size) {
+    uint32_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256 aRe = _mm256_loadu_ps(re + i);
+        __m256 aIm = _mm256_loadu_ps(im + i);
+        __m256 bRe = _mm256_loadu_ps(otherRe + i);
+        __m256 bIm = _mm256_loadu_ps(otherIm + i);
+        _mm256_storeu_ps(re + i, _mm256_fmsub_ps(aRe, bRe, _mm256_mul_ps(aIm, bIm)));
+        _mm256_storeu_ps(im + i, _mm256_fmadd_ps(aRe, bIm, _mm256_mul_ps(aIm, bRe)));
+    }
+    MultiplyScalar(re + i, im + i, otherRe + i, otherIm + i, size - i);
+}
+__attribute__((target("avx2,fma")))
+void ToInt16AVX(const float* input, int16_t* output, uint32_t size, float factor) {
+    uint32_t i = 0;
+    __m256 scale = _mm256_set1_ps(factor);
+    __m256 low = _mm256_set1_ps(-32768.0f);
+    __m256 high = _mm256_set1_ps(32767.0f);
+    __m256 half = _mm256_set1_ps(0.5f);
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 signMask = _mm256_set1_ps(-0.0f);
+    for (; i + 8 <= size; i += 8) {
+        __m256 value = _mm256_mul_ps(_mm256_loadu_ps(input + i), scale);
+        __m256 truncated = _mm256_round_ps(value, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+        __m256 fraction = _mm256_andnot_ps(signMask, _mm256_sub_ps(value, truncated));
+        __m256 step = _mm256_or_ps(_mm256_and_ps(value, signMask), one);
+        __m256 rounded = _mm256_add_ps(truncated, _mm256_and_ps(_mm256_cmp_ps(fraction, half, _CMP_GE_OQ), step));
+        __m256i integers = _mm256_cvtps_epi32(_mm256_min_ps(high, _mm256_max_ps(low, rounded)));
+        __m128i packed = _mm_packs_epi32(_mm256_castsi256_si128(integers), _mm256_extracti128_si256(integers, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+    }
+    ToInt16Scalar(input + i, output + i, size - i, factor);
+}
+__attribute__((target("avx2,fma")))
+void FromInt16AVX(const int16_t* input, float* output, uint32_t size, float factor) {
+    uint32_t i = 0;
+    __m256 scale = _mm256_set1_ps(factor);
+    for (; i + 8 <= size; i += 8) {
+        __m256i integers = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(integers), scale));
+    }
+    FromInt16Scalar(input + i, output + i, size - i, factor);
+}
+#endif
+
+SimdLevel GetSupportedSimdLevel() {
+#ifdef SIMD_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return avxLevel;
+    if (__builtin_cpu_supports("sse2"))
+        return sseLevel;
+#endif
+    return scalarLevel;
+}
+
+template<typename Real = double>
+SimdKernels<Real> GetSimdKernels(SimdLevel level) {
+    level = std::min(level, GetSupportedSimdLevel());
+#ifdef SIMD_X86
+    if (level == avxLevel)
+        return {avxLevel, Radix4StageAVX, MultiplyAVX, ToInt16AVX, FromInt16AVX};
+    if (level == sseLevel)
+        return {sseLevel, Radix4StageSSE, MultiplySSE, ToInt16SSE, FromInt16SSE};
+#endif
+    return {scalarLevel, Radix4StageScalar<Real>, MultiplyScalar<Real>, ToInt16Scalar<Real>, FromInt16Scalar<Real>};
+}
+
+template<typename Real>
+SimdKernels<Real>& GetMutableSimdKernels() {
+    static SimdKernels<Real> kernels = GetSimdKernels<Real>(avxLevel);
+    return kernels;
+}
+
+// The kernels in use, the best supported ones unless SetSimdLevel said otherwise.
+template<typename Real = double>
+const SimdKernels<Real>& GetSimdKernels() {
+    return GetMutableSimdKernels<Real>();
+}
+
+// Switches every kernel to the given level, or to the best supported one below it. Meant for benchmarks that need
+// a scalar baseline; not safe while kernels are running on other threads.
+void SetSimdLevel(const SimdLevel& level) {
+    GetMutableSimdKernels<double>() = GetSimdKernels<double>(level);
+    GetMutableSimdKernels<float>() = GetSimdKernels<float>(level);
+}
+
+#endif
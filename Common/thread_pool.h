@@ -0,0 +1,202 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool: each worker pops tasks from the back of its own deque and steals from the front of the
+// others'. Tasks spawned by a worker go to its own deque, tasks from outside threads are dealt round-robin.
+class ThreadPool {
+    public:
+        explicit ThreadPool(const unsigned int&);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+        static std::unique_ptr<ThreadPool>& GetInstance();
+        unsigned int GetThreadCount() const;
+        void Push(std::function<void()>);
+        bool RunOne();
+    private:
+        struct Worker {
+            std::mutex mutex;
+            std::deque<std::function<void()>> tasks;
+        };
+        std::vector<std::unique_ptr<Worker>> workers;
+        std::vector<std::thread> threads;
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+        std::atomic<unsigned int> queuedCount;
+        std::atomic<unsigned int> nextWorker;
+        bool isStopping = false;
+        static int& GetWorkerIndex();
+        void WorkerLoop(const unsigned int&);
+};
+// Runs tasks on the shared pool when there is one and isParallel holds, and inline otherwise. Wait() executes queued
+// tasks (its own or others') instead of blocking, so nested groups cannot deadlock; the first exception of a task is
+// rethrown.
+class TaskGroup {
+    public:
+        explicit TaskGroup(const bool& = true);
+        ~TaskGroup();
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+        template<typename Task>
+        void Run(Task&&);
+        void Wait();
+    private:
+        ThreadPool* pool;
+        std::atomic<unsigned int> pendingCount;
+        std::mutex exceptionMutex;
+        std::exception_ptr exception;
+};
+
+ThreadPool::ThreadPool(const unsigned int& threadCount) : queuedCount(0), nextWorker(0) {
+    for (unsigned int i = 0; i < threadCount; ++i)
+        workers.emplace_back(new Worker());
+    for (unsigned int i = 0; i < threadCount; ++i)
+        threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        isStopping = true;
+    }
+    wakeUp.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+std::unique_ptr<ThreadPool>& ThreadPool::GetInstance() {
+    static std::unique_ptr<ThreadPool> pool;
+    return pool;
+}
+int& ThreadPool::GetWorkerIndex() {
+    static thread_local int workerIndex = -1;
+    return workerIndex;
+}
+unsigned int ThreadPool::GetThreadCount() const {
+    return workers.size();
+}
+void ThreadPool::Push(std::function<void()> task) {
+    int workerIndex = GetWorkerIndex();
+    unsigned int index = (workerIndex >= 0 ? workerIndex : nextWorker++ % workers.size());
+    {
+        std::lock_guard<std::mutex> lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queuedCount;
+    }
+    wakeUp.notify_one();
+}
+bool ThreadPool::RunOne() {
+    int workerIndex = GetWorkerIndex();
+    unsigned int start = (workerIndex >= 0 ? workerIndex : 0);
+    for (unsigned int i = 0; i < workers.size(); ++i) {
+        Worker& worker = *workers[(start + i) % workers.size()];
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.tasks.empty())
+                continue;
+            if (i == 0 && workerIndex >= 0) {
+                task = std::move(worker.tasks.back());
+                worker.tasks.pop_back();
+            }
+            else {
+                task = std::move(worker.tasks.front());
+                worker.tasks.pop_front();
+            }
+        }
+        --queuedCount;
+        task();
+        return true;
+    }
+    return false;
+}
+void ThreadPool::WorkerLoop(const unsigned int& index) {
+    GetWorkerIndex() = index;
+    while (true) {
+        if (RunOne())
+            continue;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this] { return isStopping || (queuedCount > 0); });
+        if (isStopping)
+            return;
+    }
+}
+TaskGroup::TaskGroup(const bool& isParallel)
+    : pool(isParallel ? ThreadPool::GetInstance().get() : nullptr), pendingCount(0) {}
+TaskGroup::~TaskGroup() {
+    while (pendingCount > 0)
+        if (!pool->RunOne())
+            std::this_thread::yield();
+}
+template<typename Task>
+void TaskGroup::Run(Task&& task) {
+    if (pool == nullptr) {
+        task();
+        return;
+    }
+    ++pendingCount;
+    pool->Push([this, task] {
+        try {
+            task();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(exceptionMutex);
+            if (!exception)
+                exception = std::current_exception();
+        }
+        --pendingCount;
+    });
+}
+void TaskGroup::Wait() {
+    while (pendingCount > 0)
+        if (!pool->RunOne())
+            std::this_thread::yield();
+    if (exception)
+        std::rethrow_exception(exception);
+}
+
+// Runs body(from, to) over consecutive ranges that cover [begin, end), as tasks of a TaskGroup when there is a pool and
+// the range holds at least two grains, and inline in one call otherwise.
+template<typename Body>
+void ParallelFor(const size_t& begin, const size_t& end, const size_t& grainSize, const Body& body) {
+    if (end <= begin)
+        return;
+    ThreadPool* pool = ThreadPool::GetInstance().get();
+    size_t size = end - begin;
+    if ((pool == nullptr) || (size < 2 * grainSize)) {
+        body(begin, end);
+        return;
+    }
+    size_t rangeCount = std::min<size_t>(size / grainSize, 4 * pool->GetThreadCount());
+    size_t rangeSize = (size + rangeCount - 1) / rangeCount;
+    TaskGroup ranges;
+    for (size_t from = begin; from < end; from += rangeSize)
+        ranges.Run([&body, from, end, rangeSize] { body(from, std::min(end, from + rangeSize)); });
+    ranges.Wait();
+}
+
+// Creates the shared pool with the given number of threads, capped at the hardware concurrency; one thread or
+// fewer means everything runs on the calling thread.
+void SetParallelism(unsigned int threadCount) {
+    if (std::thread::hardware_concurrency() != 0)
+        threadCount = std::min(threadCount, std::thread::hardware_concurrency());
+    std::unique_ptr<ThreadPool>& pool = ThreadPool::GetInstance();
+    if ((threadCount > 1) && (!pool || (pool->GetThreadCount() != threadCount)))
+        pool.reset(new ThreadPool(threadCount));
+    else if (threadCount <= 1)
+        pool.reset();
+}
+
+#endif
@@ -1,7 +1,9 @@
 #include <algorithm>
 #include <cstdint>
 #include <iostream>
+#include <stdexcept>
 #include <vector>
+#include "../Common/fast_io.h"
 
 int32_t GetMinDayCount(int32_t requestedBacteriaCount) {
     std::vector<int32_t> cache(requestedBacteriaCount + 1);
@@ -19,8 +21,16 @@ int32_t GetMinDayCount(int32_t requestedBacteriaCount) {
 }
 
 int main() {
-    int32_t requestedBacteriaCount = 0;
-    std::cin >> requestedBacteriaCount;
-    std::cout << GetMinDayCount(requestedBacteriaCount) << std::endl;
+    try {
+        InputReader reader;
+        OutputWriter writer;
+        int32_t requestedBacteriaCount = 0;
+        reader >> requestedBacteriaCount;
+        writer << GetMinDayCount(requestedBacteriaCount) << '\n';
+        writer.Flush();
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
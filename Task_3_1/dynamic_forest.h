@@ -0,0 +1,218 @@
+#ifndef DYNAMIC_FOREST_H
+#define DYNAMIC_FOREST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Forest of unrooted trees under edge insertions and deletions, answering farthest-distance queries, all in amortized
+// O(log^2 n) time. It is a link-cut tree: every tree is cut into preferred paths, each kept in a splay tree ordered
+// from the top of the path to its bottom, and the other children of a node (the tops of the paths hanging from it)
+// are its virtual children. A splay subtree covers a segment of a path together with everything hanging from it,
+// and keeps the distance from the top and from the bottom of the segment to the farthest of those nodes; a node keeps
+// the lengths down into its virtual subtrees in a multiset, as they change whenever a subtree is spliced in or out.
+// The multisets live apart from the 32-byte nodes, which splaying touches far more often and only needs their maximum.
+class DynamicForest {
+    public:
+        // nodeCount isolated nodes.
+        explicit DynamicForest(const int32_t&);
+        int32_t GetNodeCount() const;
+        // Adds the edge u-v; u and v must be in different trees.
+        void Link(const int32_t&, const int32_t&);
+        // Removes the edge u-v, which must exist.
+        void Cut(const int32_t&, const int32_t&);
+        // Largest number of edges between v and a node of its tree.
+        int32_t GetEccentricity(const int32_t&);
+        bool IsConnected(const int32_t&, const int32_t&);
+    private:
+        struct Node {
+            int32_t parent = -1;
+            int32_t children[2] = {-1, -1};
+            // Nodes of the path segment, and the farthest distances from its top and its bottom.
+            int32_t count = 1;
+            int32_t lengthFromTop = 0;
+            int32_t lengthFromBottom = 0;
+            // Largest of the virtualLengths, 0 if there are none.
+            int32_t lengthDown = 0;
+            // The children have to swap sides (this node is already reversed).
+            bool isFlipped = false;
+        };
+        static const int32_t noLength = std::numeric_limits<int32_t>::min() / 2;
+        std::vector<Node> nodes;
+        // One plus the lengthFromTop of every virtual child of a node.
+        std::vector<std::multiset<int32_t>> virtualLengths;
+        std::vector<int32_t> pathToRoot;
+        void CheckIndex(const int32_t&) const;
+        void AddVirtualLength(const int32_t&, const int32_t&);
+        void RemoveVirtualLength(const int32_t&, const int32_t&);
+        bool IsSplayRoot(const int32_t&) const;
+        void Update(const int32_t&);
+        void Flip(const int32_t&);
+        void PushDown(const int32_t&);
+        void Rotate(const int32_t&);
+        void Splay(const int32_t&);
+        void Access(const int32_t&);
+        void MakeRoot(const int32_t&);
+        int32_t FindRoot(const int32_t&);
+};
+
+DynamicForest::DynamicForest(const int32_t& nodeCount)
+    : nodes(std::max(nodeCount, 0)), virtualLengths(std::max(nodeCount, 0)) {}
+int32_t DynamicForest::GetNodeCount() const {
+    return nodes.size();
+}
+void DynamicForest::CheckIndex(const int32_t& index) const {
+    if (index < 0 || index >= static_cast<int32_t>(nodes.size()))
+        throw std::runtime_error("Node index out of range.");
+}
+void DynamicForest::AddVirtualLength(const int32_t& index, const int32_t& length) {
+    virtualLengths[index].insert(length);
+    nodes[index].lengthDown = std::max(nodes[index].lengthDown, length);
+}
+void DynamicForest::RemoveVirtualLength(const int32_t& index, const int32_t& length) {
+    std::multiset<int32_t>& lengths = virtualLengths[index];
+    lengths.erase(lengths.find(length));
+    nodes[index].lengthDown = (lengths.empty() ? 0 : *lengths.rbegin());
+}
+bool DynamicForest::IsSplayRoot(const int32_t& index) const {
+    int32_t parent = nodes[index].parent;
+    return parent < 0 || (nodes[parent].children[0] != index && nodes[parent].children[1] != index);
+}
+void DynamicForest::Update(const int32_t& index) {
+    Node& node = nodes[index];
+    int32_t above = node.children[0];
+    int32_t below = node.children[1];
+    int32_t countAbove = (above < 0 ? 0 : nodes[above].count);
+    int32_t countBelow = (below < 0 ? 0 : nodes[below].count);
+    int32_t lengthDown = node.lengthDown;
+    node.count = countAbove + 1 + countBelow;
+    node.lengthFromTop = std::max(countAbove + lengthDown, countAbove + 1 + (below < 0 ? noLength : nodes[below].lengthFromTop));
+    node.lengthFromBottom = std::max(countBelow + lengthDown, countBelow + 1 + (above < 0 ? noLength : nodes[above].lengthFromBottom));
+    if (above >= 0)
+        node.lengthFromTop = std::max(node.lengthFromTop, nodes[above].lengthFromTop);
+    if (below >= 0)
+        node.lengthFromBottom = std::max(node.lengthFromBottom, nodes[below].lengthFromBottom);
+}
+void DynamicForest::Flip(const int32_t& index) {
+    if (index < 0)
+        return;
+    Node& node = nodes[index];
+    std::swap(node.children[0], node.children[1]);
+    std::swap(node.lengthFromTop, node.lengthFromBottom);
+    node.isFlipped = !node.isFlipped;
+}
+void DynamicForest::PushDown(const int32_t& index) {
+    if (!nodes[index].isFlipped)
+        return;
+    Flip(nodes[index].children[0]);
+    Flip(nodes[index].children[1]);
+    nodes[index].isFlipped = false;
+}
+void DynamicForest::Rotate(const int32_t& index) {
+    int32_t parent = nodes[index].parent;
+    int32_t grandparent = nodes[parent].parent;
+    int32_t side = (nodes[parent].children[1] == index);
+    if (!IsSplayRoot(parent))
+        nodes[grandparent].children[nodes[grandparent].children[1] == parent] = index;
+    nodes[index].parent = grandparent;
+    int32_t moved = nodes[index].children[!side];
+    nodes[parent].children[side] = moved;
+    if (moved >= 0)
+        nodes[moved].parent = parent;
+    nodes[index].children[!side] = parent;
+    nodes[parent].parent = index;
+    Update(parent);
+    Update(index);
+}
+// Flips are pushed down from the splay root first, so rotations see every child on its final side.
+void DynamicForest::Splay(const int32_t& index) {
+    pathToRoot.clear();
+    pathToRoot.push_back(index);
+    for (int32_t current = index; !IsSplayRoot(current); current = nodes[current].parent)
+        pathToRoot.push_back(nodes[current].parent);
+    for (size_t i = pathToRoot.size(); i-- > 0;)
+        PushDown(pathToRoot[i]);
+    while (!IsSplayRoot(index)) {
+        int32_t parent = nodes[index].parent;
+        if (!IsSplayRoot(parent)) {
+            int32_t grandparent = nodes[parent].parent;
+            bool isZigZig = (nodes[grandparent].children[1] == parent) == (nodes[parent].children[1] == index);
+            Rotate(isZigZig ? parent : index);
+        }
+        Rotate(index);
+    }
+}
+// Makes the path from the root of the tree down to index preferred, ending at index, with index the splay root. The
+// paths that stop being preferred become virtual children and the joined ones leave the multisets; the farthest
+// distance from the top of a path never changes while it hangs, so the erased length is always the inserted one.
+void DynamicForest::Access(const int32_t& index) {
+    for (int32_t current = index, below = -1; current >= 0; below = current, current = nodes[current].parent) {
+        Splay(current);
+        if (nodes[current].children[1] >= 0)
+            AddVirtualLength(current, nodes[nodes[current].children[1]].lengthFromTop + 1);
+        if (below >= 0)
+            RemoveVirtualLength(current, nodes[below].lengthFromTop + 1);
+        nodes[current].children[1] = below;
+        Update(current);
+    }
+    Splay(index);
+}
+void DynamicForest::MakeRoot(const int32_t& index) {
+    Access(index);
+    Flip(index);
+}
+int32_t DynamicForest::FindRoot(const int32_t& index) {
+    Access(index);
+    int32_t root = index;
+    for (PushDown(root); nodes[root].children[0] >= 0; PushDown(root))
+        root = nodes[root].children[0];
+    Splay(root);
+    return root;
+}
+bool DynamicForest::IsConnected(const int32_t& u, const int32_t& v) {
+    CheckIndex(u);
+    CheckIndex(v);
+    return u == v || FindRoot(u) == FindRoot(v);
+}
+// With u the root, v is connected to it exactly when the root of v's tree is u. FindRoot leaves the path to v
+// preferred, so splaying v makes it the top of the whole auxiliary tree again.
+void DynamicForest::Link(const int32_t& u, const int32_t& v) {
+    CheckIndex(u);
+    CheckIndex(v);
+    MakeRoot(u);
+    if (FindRoot(v) == u)
+        throw std::runtime_error("Linked nodes are already connected.");
+    Splay(v);
+    nodes[u].parent = v;
+    AddVirtualLength(v, nodes[u].lengthFromTop + 1);
+    Update(v);
+}
+// With u the root and v accessed, the edge exists exactly when u is the only node above v on the path.
+void DynamicForest::Cut(const int32_t& u, const int32_t& v) {
+    CheckIndex(u);
+    CheckIndex(v);
+    MakeRoot(u);
+    Access(v);
+    int32_t above = nodes[v].children[0];
+    if (above != u)
+        throw std::runtime_error("Cut edge does not exist.");
+    PushDown(u);
+    if (nodes[u].children[1] >= 0)
+        throw std::runtime_error("Cut edge does not exist.");
+    nodes[v].children[0] = -1;
+    nodes[u].parent = -1;
+    Update(v);
+}
+// After the access v is the bottom of a path that starts at the root, so its farthest distance from the bottom covers
+// the whole tree.
+int32_t DynamicForest::GetEccentricity(const int32_t& index) {
+    CheckIndex(index);
+    Access(index);
+    return nodes[index].lengthFromBottom;
+}
+
+#endif
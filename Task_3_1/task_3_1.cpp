@@ -1,63 +1,464 @@
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
 #include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
+#include "../Common/fast_io.h"
+#include "../Common/thread_pool.h"
+#include "dynamic_forest.h"
 
-struct Node {
-    int32_t parent = 0;
-    int32_t height1 = 0; // max0 height
-    int32_t height2 = 0; // max1 height
-    int32_t lengthToOutermostPeak = 0;
-    std::vector<int32_t> children;
+// Smallest number of edges or positions worth a task of their own in the multi-core mode.
+const int32_t parallelGrainSize = 1 << 14;
+
+// Tree rooted at node 0 in compressed sparse row form, with positions in breadth-first order: order[i] is the node
+// at position i and the children of position i are the positions childOffsets[i]..childOffsets[i + 1], always
+// consecutive and after i. Every pass over the tree is then a single sweep over flat arrays, front to back or back
+// to front, with no recursion. Level k of the tree is the positions levelOffsets[k]..levelOffsets[k + 1]; positions
+// of one level never depend on each other, which is what the multi-core mode splits.
+struct Tree {
+    std::vector<int32_t> order;
+    std::vector<int32_t> childOffsets;
+    std::vector<int32_t> levelOffsets;
+};
+
+// Longest downward paths of every position, in edges: height1 through its highest child and height2 through another
+// child (0 if there is none), kept as separate arrays so each sweep only touches what it needs.
+struct Heights {
+    std::vector<int32_t> height1;
+    std::vector<int32_t> height2;
 };
 
-void SetHeight(int32_t nodeIndex, std::vector<Node>& tree) {
-    for (int32_t iNodeIndex : tree[nodeIndex].children) {
-        SetHeight(iNodeIndex, tree);
-        if (tree[iNodeIndex].height1 >= tree[nodeIndex].height2) {
-            tree[nodeIndex].height2 = tree[iNodeIndex].height1 + 1;
-            if (tree[nodeIndex].height2 > tree[nodeIndex].height1)
-                std::swap(tree[nodeIndex].height1, tree[nodeIndex].height2);
+// sums[i] = first + getValue(0) + ... + getValue(i - 1) for i in [0, count]. Long runs are cut into grains: the grain
+// totals are added up in parallel, scanned, and then every grain writes its own sums from the total before it.
+template<typename GetValue>
+void SetPrefixSums(int32_t* sums, const int32_t& count, const int32_t& first, const GetValue& getValue) {
+    if (count < 2 * parallelGrainSize) {
+        sums[0] = first;
+        for (int32_t i = 0; i < count; ++i)
+            sums[i + 1] = sums[i] + getValue(i);
+        return;
+    }
+    int32_t grainCount = (count + parallelGrainSize - 1) / parallelGrainSize;
+    std::vector<int32_t> starts(grainCount + 1, 0);
+    starts[0] = first;
+    ParallelFor(0, grainCount, 1, [&](const size_t& from, const size_t& to) {
+        for (size_t grain = from; grain < to; ++grain) {
+            int32_t end = std::min<int32_t>(count, (grain + 1) * parallelGrainSize);
+            int32_t total = 0;
+            for (int32_t i = grain * parallelGrainSize; i < end; ++i)
+                total += getValue(i);
+            starts[grain + 1] = total;
+        }
+    });
+    for (int32_t grain = 0; grain < grainCount; ++grain)
+        starts[grain + 1] += starts[grain];
+    ParallelFor(0, grainCount, 1, [&](const size_t& from, const size_t& to) {
+        for (size_t grain = from; grain < to; ++grain) {
+            int32_t end = std::min<int32_t>(count, (grain + 1) * parallelGrainSize);
+            int32_t sum = starts[grain];
+            for (int32_t i = grain * parallelGrainSize; i < end; ++i) {
+                sums[i] = sum;
+                sum += getValue(i);
+            }
         }
+    });
+    sums[count] = starts[grainCount];
+}
+
+// GetTree on the shared pool, with the same adjacency and the same BFS order as the sequential build. The edge ends
+// are first partitioned by the node range they belong to: every chunk of the edge list counts its ends per range, a
+// prefix sum over (range, chunk) gives every chunk its slot in every range's bucket, and a stable scatter fills the
+// buckets. Every range then builds its own part of the adjacency from its bucket alone, so each end is touched a
+// constant number of times, no write needs an atomic, and the neighbours keep the order of the edge list. The BFS
+// runs level-synchronously: the children of a level are counted from the degrees (all neighbours but the parent),
+// placed by a prefix sum and then written by every position of the level independently.
+Tree GetTreeInParallel(const int32_t& nodeCount, std::vector<int32_t> edgeEnds) {
+    size_t taskCount = 4 * ThreadPool::GetInstance()->GetThreadCount();
+    size_t endCount = edgeEnds.size();
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(endCount / parallelGrainSize, taskCount));
+    size_t chunkSize = std::max<size_t>(1, (endCount + chunkCount - 1) / chunkCount);
+    uint32_t rangeCount = std::min<size_t>(nodeCount, taskCount);
+    uint32_t rangeSize = (static_cast<uint32_t>(nodeCount) + rangeCount - 1) / rangeCount;
+    // Slot of chunk c in the bucket of range r at bucketOffsets[r * chunkCount + c]; the bucket of r ends where the
+    // one of r + 1 starts.
+    std::vector<size_t> bucketOffsets(rangeCount * chunkCount + 1, 0);
+    std::vector<int32_t> bucketNodes(endCount);
+    std::vector<int32_t> bucketNeighbours(endCount);
+    ParallelFor(0, chunkCount, 1, [&](const size_t& from, const size_t& to) {
+        for (size_t chunk = from; chunk < to; ++chunk) {
+            std::vector<size_t> counts(rangeCount, 0);
+            for (size_t k = chunk * chunkSize; k < std::min(endCount, (chunk + 1) * chunkSize); ++k) {
+                if (edgeEnds[k] < 0 || edgeEnds[k] >= nodeCount)
+                    throw std::runtime_error("Node index out of range.");
+                ++counts[edgeEnds[k] / rangeSize];
+            }
+            for (uint32_t range = 0; range < rangeCount; ++range)
+                bucketOffsets[range * chunkCount + chunk + 1] = counts[range];
+        }
+    });
+    for (size_t i = 0; i < rangeCount * chunkCount; ++i)
+        bucketOffsets[i + 1] += bucketOffsets[i];
+    ParallelFor(0, chunkCount, 1, [&](const size_t& from, const size_t& to) {
+        for (size_t chunk = from; chunk < to; ++chunk) {
+            std::vector<size_t> positions(rangeCount);
+            for (uint32_t range = 0; range < rangeCount; ++range)
+                positions[range] = bucketOffsets[range * chunkCount + chunk];
+            for (size_t k = chunk * chunkSize; k < std::min(endCount, (chunk + 1) * chunkSize); ++k) {
+                size_t position = positions[edgeEnds[k] / rangeSize]++;
+                bucketNodes[position] = edgeEnds[k];
+                bucketNeighbours[position] = edgeEnds[k ^ 1];
+            }
+        }
+    });
+    std::vector<int32_t>().swap(edgeEnds);
+    std::vector<int32_t> offsets(nodeCount + 1, 0);
+    std::vector<int32_t> neighbours(endCount);
+    std::vector<int32_t> degrees(nodeCount, 0);
+    {
+        ParallelFor(0, rangeCount, 1, [&](const size_t& from, const size_t& to) {
+            for (size_t k = bucketOffsets[from * chunkCount]; k < bucketOffsets[to * chunkCount]; ++k)
+                ++degrees[bucketNodes[k]];
+        });
+        SetPrefixSums(offsets.data(), nodeCount, 0, [&](const int32_t& i) { return degrees[i]; });
+        std::vector<int32_t>& positions = degrees;
+        std::copy(offsets.begin(), offsets.end() - 1, positions.begin());
+        ParallelFor(0, rangeCount, 1, [&](const size_t& from, const size_t& to) {
+            for (size_t k = bucketOffsets[from * chunkCount]; k < bucketOffsets[to * chunkCount]; ++k)
+                neighbours[positions[bucketNodes[k]]++] = bucketNeighbours[k];
+        });
     }
+    std::vector<int32_t>().swap(bucketNodes);
+    std::vector<int32_t>().swap(bucketNeighbours);
+    Tree tree;
+    tree.order.resize(nodeCount);
+    tree.childOffsets.resize(nodeCount + 1);
+    tree.levelOffsets.push_back(0);
+    // parents[i] is the node above position i. Skipping only the parent, the levels enumerate every walk from the
+    // root that never turns straight back, which are infinitely many as soon as the root reaches a cycle; n positions
+    // exactly, each with exactly its counted children (a repeated edge to the parent breaks the count), is a tree.
+    // The child counts of a level are gathered into the spare degree array first, so that the scattered degree reads
+    // happen once and can be prefetched like in the sequential BFS.
+    std::vector<int32_t> parents(nodeCount);
+    std::vector<int32_t>& childCounts = degrees;
+    tree.order[0] = 0;
+    parents[0] = -1;
+    int32_t levelBegin = 0;
+    int32_t levelEnd = 1;
+    while (levelBegin < levelEnd) {
+        tree.levelOffsets.push_back(levelEnd);
+        ParallelFor(levelBegin, levelEnd, parallelGrainSize, [&](const size_t& from, const size_t& to) {
+            for (size_t i = from; i < to; ++i) {
+                if (i + 16 < to)
+                    __builtin_prefetch(&offsets[tree.order[i + 16]]);
+                int32_t nodeIndex = tree.order[i];
+                childCounts[i] = offsets[nodeIndex + 1] - offsets[nodeIndex] - (i > 0 ? 1 : 0);
+            }
+        });
+        SetPrefixSums(&tree.childOffsets[levelBegin], levelEnd - levelBegin, levelEnd,
+                      [&](const int32_t& i) { return childCounts[levelBegin + i]; });
+        int32_t nextLevelEnd = tree.childOffsets[levelEnd];
+        if (nextLevelEnd > nodeCount)
+            throw std::runtime_error("Edges do not form a tree.");
+        ParallelFor(levelBegin, levelEnd, parallelGrainSize, [&](const size_t& from, const size_t& to) {
+            for (size_t i = from; i < to; ++i) {
+                if (i + 16 < to)
+                    __builtin_prefetch(&offsets[tree.order[i + 16]]);
+                if (i + 8 < to)
+                    __builtin_prefetch(&neighbours[offsets[tree.order[i + 8]]]);
+                int32_t nodeIndex = tree.order[i];
+                int32_t child = tree.childOffsets[i];
+                for (int32_t j = offsets[nodeIndex]; j < offsets[nodeIndex + 1]; ++j) {
+                    if (neighbours[j] == parents[i])
+                        continue;
+                    if (child == tree.childOffsets[i + 1])
+                        throw std::runtime_error("Edges do not form a tree.");
+                    tree.order[child] = neighbours[j];
+                    parents[child] = nodeIndex;
+                    ++child;
+                }
+                if (child != tree.childOffsets[i + 1])
+                    throw std::runtime_error("Edges do not form a tree.");
+            }
+        });
+        levelBegin = levelEnd;
+        levelEnd = nextLevelEnd;
+    }
+    if (levelEnd != nodeCount)
+        throw std::runtime_error("Edges do not form a tree.");
+    return tree;
 }
 
-void SetLengthToFurthestPeak(int32_t nodeIndex, std::vector<Node>& tree) {
-    if (tree[nodeIndex].height1 + 1 == tree[tree[nodeIndex].parent].height1)
-        tree[nodeIndex].lengthToOutermostPeak = tree[tree[nodeIndex].parent].height2 + 1;
-    else
-        tree[nodeIndex].lengthToOutermostPeak = tree[tree[nodeIndex].parent].height1 + 1;
-    tree[nodeIndex].lengthToOutermostPeak = std::max(tree[tree[nodeIndex].parent].lengthToOutermostPeak + 1, tree[nodeIndex].lengthToOutermostPeak);
-    for (int32_t iNodeIndex : tree[nodeIndex].children) {
-        SetLengthToFurthestPeak(iNodeIndex, tree);
-        tree[iNodeIndex].lengthToOutermostPeak = std::max(tree[iNodeIndex].lengthToOutermostPeak, tree[iNodeIndex].height1);
+// Roots the tree given by its edges (the ends of edge k are edgeEnds[2k] and edgeEnds[2k + 1], in any orientation)
+// at node 0. The edges are taken by value and released as soon as the adjacency arrays are built.
+Tree GetTree(const int32_t& nodeCount, std::vector<int32_t> edgeEnds) {
+    if (ThreadPool::GetInstance())
+        return GetTreeInParallel(nodeCount, std::move(edgeEnds));
+    std::vector<int32_t> offsets(nodeCount + 1, 0);
+    for (int32_t end : edgeEnds) {
+        if (end < 0 || end >= nodeCount)
+            throw std::runtime_error("Node index out of range.");
+        ++offsets[end + 1];
     }
+    for (int32_t i = 0; i < nodeCount; ++i)
+        offsets[i + 1] += offsets[i];
+    std::vector<int32_t> neighbours(edgeEnds.size());
+    {
+        std::vector<int32_t> positions(offsets.begin(), offsets.end() - 1);
+        for (size_t k = 0; k < edgeEnds.size(); k += 2) {
+            neighbours[positions[edgeEnds[k]]++] = edgeEnds[k + 1];
+            neighbours[positions[edgeEnds[k + 1]]++] = edgeEnds[k];
+        }
+    }
+    std::vector<int32_t>().swap(edgeEnds);
+    Tree tree;
+    tree.order.reserve(nodeCount);
+    tree.childOffsets.resize(nodeCount + 1);
+    tree.levelOffsets.push_back(0);
+    std::vector<bool> isVisited(nodeCount, false);
+    tree.order.push_back(0);
+    isVisited[0] = true;
+    // order doubles as the queue: the nodes discovered from position i are exactly its children. Node indices in the
+    // queue are arbitrary, so the adjacency of the nodes a few positions ahead is prefetched in two steps. When the
+    // sweep reaches the end of a level, everything queued so far is the next level.
+    int32_t levelEnd = 1;
+    for (int32_t i = 0; i < static_cast<int32_t>(tree.order.size()); ++i) {
+        int32_t nodeIndex = tree.order[i];
+        int32_t queuedCount = tree.order.size();
+        if (i == levelEnd) {
+            tree.levelOffsets.push_back(i);
+            levelEnd = queuedCount;
+        }
+        if (i + 16 < queuedCount)
+            __builtin_prefetch(&offsets[tree.order[i + 16]]);
+        if (i + 8 < queuedCount)
+            __builtin_prefetch(&neighbours[offsets[tree.order[i + 8]]]);
+        tree.childOffsets[i] = queuedCount;
+        for (int32_t j = offsets[nodeIndex]; j < offsets[nodeIndex + 1]; ++j)
+            if (!isVisited[neighbours[j]]) {
+                isVisited[neighbours[j]] = true;
+                tree.order.push_back(neighbours[j]);
+            }
+    }
+    // n - 1 edges that connect n nodes always form a tree.
+    if (static_cast<int32_t>(tree.order.size()) != nodeCount)
+        throw std::runtime_error("Edges do not form a tree.");
+    tree.childOffsets[nodeCount] = nodeCount;
+    tree.levelOffsets.push_back(nodeCount);
+    return tree;
+}
+
+// Heights of the positions from..to, back to front, from the finished heights of their children.
+void SetHeights(const Tree& tree, Heights& heights, const int32_t& from, const int32_t& to) {
+    for (int32_t i = to - 1; i >= from; --i)
+        for (int32_t child = tree.childOffsets[i]; child < tree.childOffsets[i + 1]; ++child) {
+            int32_t height = heights.height1[child] + 1;
+            if (height > heights.height1[i]) {
+                heights.height2[i] = heights.height1[i];
+                heights.height1[i] = height;
+            }
+            else if (height > heights.height2[i])
+                heights.height2[i] = height;
+        }
 }
 
-void SetFurthestPeakForAllPeaks(std::vector<Node>& tree) {
-    SetHeight(0, tree);
-    for (int32_t iNodeIndex : tree[0].children) {
-        SetLengthToFurthestPeak(iNodeIndex, tree);
-        tree[iNodeIndex].lengthToOutermostPeak = std::max(tree[iNodeIndex].lengthToOutermostPeak, tree[iNodeIndex].height1);
+// Children come after their parent, so a back-to-front sweep sees every subtree complete; on the shared pool the
+// levels go deepest first, each split across the threads.
+Heights GetHeights(const Tree& tree) {
+    int32_t nodeCount = tree.order.size();
+    Heights heights;
+    heights.height1.assign(nodeCount, 0);
+    heights.height2.assign(nodeCount, 0);
+    if (!ThreadPool::GetInstance()) {
+        SetHeights(tree, heights, 0, nodeCount);
+        return heights;
+    }
+    for (size_t level = tree.levelOffsets.size() - 1; level-- > 0;)
+        ParallelFor(tree.levelOffsets[level], tree.levelOffsets[level + 1], parallelGrainSize,
+                    [&](const size_t& from, const size_t& to) { SetHeights(tree, heights, from, to); });
+    return heights;
+}
+
+// Farthest distances of the positions from..to, front to back, and the upward lengths of their children.
+void SetLengthsToFurthestPeak(const Tree& tree, const Heights& heights, const int32_t& from, const int32_t& to,
+                              std::vector<int32_t>& lengthsUp, std::vector<int32_t>& lengths) {
+    for (int32_t i = from; i < to; ++i) {
+        for (int32_t child = tree.childOffsets[i]; child < tree.childOffsets[i + 1]; ++child) {
+            bool isOnHighestPath = heights.height1[child] + 1 == heights.height1[i];
+            int32_t lengthDown = (isOnHighestPath ? heights.height2[i] : heights.height1[i]);
+            lengthsUp[child] = std::max(lengthsUp[i], lengthDown) + 1;
+        }
+        lengths[tree.order[i]] = std::max(lengthsUp[i], heights.height1[i]);
     }
-    tree[0].lengthToOutermostPeak = tree[0].height1;
 }
 
-int main() {
+// Rerooting: the longest path leaving a child upwards goes through its parent and then either further up or down
+// into the parent's best subtree that does not contain the child. A front-to-back sweep has every parent's value
+// ready before its children; on the shared pool the levels go top down, each split across the threads. The result
+// is indexed by node.
+std::vector<int32_t> GetLengthsToFurthestPeak(const Tree& tree, const Heights& heights) {
+    int32_t nodeCount = tree.order.size();
+    std::vector<int32_t> lengthsUp(nodeCount, 0);
+    std::vector<int32_t> lengths(nodeCount);
+    if (!ThreadPool::GetInstance()) {
+        SetLengthsToFurthestPeak(tree, heights, 0, nodeCount, lengthsUp, lengths);
+        return lengths;
+    }
+    for (size_t level = 0; level + 1 < tree.levelOffsets.size(); ++level)
+        ParallelFor(tree.levelOffsets[level], tree.levelOffsets[level + 1], parallelGrainSize,
+                    [&](const size_t& from, const size_t& to) {
+                        SetLengthsToFurthestPeak(tree, heights, from, to, lengthsUp, lengths);
+                    });
+    return lengths;
+}
+
+// Edges of a random tree in the input layout, with shuffled labels, orientations and edge order. Node i > 0 of the
+// unshuffled tree hangs off a uniformly random earlier node (logarithmic depth, wide levels) or, if isDeep, off one of
+// the 16 nodes before it (depth about n / 8, levels of a few nodes).
+std::vector<int32_t> GetRandomTreeEdges(const int32_t& nodeCount, const bool& isDeep, std::mt19937& generator) {
+    std::vector<int32_t> labels(nodeCount);
+    for (int32_t i = 0; i < nodeCount; ++i)
+        labels[i] = i;
+    std::shuffle(labels.begin(), labels.end(), generator);
+    std::vector<int32_t> edgeEnds(2 * static_cast<size_t>(nodeCount - 1));
+    for (int32_t i = 1; i < nodeCount; ++i) {
+        int32_t parent = (isDeep ? std::max(0, i - 1 - static_cast<int32_t>(generator() % 16)) : generator() % i);
+        bool isFlipped = generator() % 2;
+        edgeEnds[2 * (i - 1) + isFlipped] = labels[i];
+        edgeEnds[2 * (i - 1) + !isFlipped] = labels[parent];
+    }
+    for (int32_t k = nodeCount - 2; k > 0; --k) {
+        int32_t other = generator() % (k + 1);
+        std::swap(edgeEnds[2 * k], edgeEnds[2 * other]);
+        std::swap(edgeEnds[2 * k + 1], edgeEnds[2 * other + 1]);
+    }
+    return edgeEnds;
+}
+
+// Scaling benchmark: both tree shapes at every power of two threads up to the hardware concurrency, one line per run
+// with the time of every stage, the speedup over the sequential sweeps and whether the result is identical to theirs.
+void RunBenchmark(const int32_t& nodeCount) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<unsigned int> threadCounts = {1};
+    unsigned int hardwareThreadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threadCount = 2; threadCount < hardwareThreadCount; threadCount *= 2)
+        threadCounts.push_back(threadCount);
+    if (hardwareThreadCount > 1)
+        threadCounts.push_back(hardwareThreadCount);
+    std::cout << std::left << std::setw(8) << "shape" << std::right << std::setw(8) << "threads" << std::setw(12)
+              << "build ms" << std::setw(12) << "heights ms" << std::setw(12) << "reroot ms" << std::setw(12)
+              << "total ms" << std::setw(10) << "speedup" << "  exact" << std::endl;
+    for (bool isDeep : {false, true}) {
+        std::mt19937 generator(nodeCount);
+        std::vector<int32_t> edgeEnds = GetRandomTreeEdges(nodeCount, isDeep, generator);
+        std::vector<int32_t> expected;
+        double sequentialTime = 0;
+        for (unsigned int threadCount : threadCounts) {
+            SetParallelism(threadCount);
+            Clock::time_point start = Clock::now();
+            Tree tree = GetTree(nodeCount, edgeEnds);
+            Clock::time_point built = Clock::now();
+            Heights heights = GetHeights(tree);
+            Clock::time_point measured = Clock::now();
+            std::vector<int32_t> lengths = GetLengthsToFurthestPeak(tree, heights);
+            Clock::time_point finished = Clock::now();
+            std::chrono::duration<double, std::milli> total = finished - start;
+            if (threadCount == 1) {
+                expected = lengths;
+                sequentialTime = total.count();
+            }
+            std::cout << std::left << std::setw(8) << (isDeep ? "deep" : "random") << std::right << std::setw(8)
+                      << threadCount << std::fixed << std::setprecision(1) << std::setw(12)
+                      << std::chrono::duration<double, std::milli>(built - start).count() << std::setw(12)
+                      << std::chrono::duration<double, std::milli>(measured - built).count() << std::setw(12)
+                      << std::chrono::duration<double, std::milli>(finished - measured).count() << std::setw(12)
+                      << total.count() << std::setprecision(2) << std::setw(10) << sequentialTime / total.count()
+                      << "  " << (lengths == expected ? "yes" : "NO") << std::endl;
+        }
+    }
+    SetParallelism(1);
+}
+
+// Dynamic mode: a node count, then commands up to the end of the input, "link u v", "cut u v" and "eccentricity v",
+// starting from isolated nodes. Every eccentricity is printed on its own line.
+void RunCommands(InputReader& input, OutputWriter& output) {
     int32_t nodeCount = 0;
-    std::cin >> nodeCount;
-    std::vector<Node> tree(nodeCount);
-    for (int32_t i = 0; i < nodeCount - 1; ++i) {
-        int32_t node1Index = 0;
-        int32_t node2Index = 0;
-        std::cin >> node1Index >> node2Index;
-        if (node1Index > node2Index)
-            std::swap(node1Index, node2Index);
-        tree[node2Index].parent = node1Index;
-        tree[node1Index].children.push_back(node2Index);
-    }
-    SetFurthestPeakForAllPeaks(tree);
-    for (Node iNode : tree)
-        std::cout << iNode.lengthToOutermostPeak << std::endl;
+    if (!(input >> nodeCount) || nodeCount < 0)
+        throw std::runtime_error("Missing node count.");
+    DynamicForest forest(nodeCount);
+    std::string command;
+    while (input >> command) {
+        int32_t u = 0;
+        int32_t v = 0;
+        if (command == "link" && input >> u >> v)
+            forest.Link(u, v);
+        else if (command == "cut" && input >> u >> v)
+            forest.Cut(u, v);
+        else if (command == "eccentricity" && input >> v)
+            output << forest.GetEccentricity(v) << '\n';
+        else
+            throw std::runtime_error("Unknown or incomplete command: " + command);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        unsigned int threadCount = 1;
+        int32_t benchmarkNodeCount = 0;
+        bool isDynamic = false;
+        bool isValid = true;
+        for (int i = 1; i < argc && isValid; ++i) {
+            if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+                threadCount = std::max(1, atoi(argv[++i]));
+            else if (strcmp(argv[i], "--benchmark") == 0 && i + 1 < argc)
+                benchmarkNodeCount = atoi(argv[++i]);
+            else if (strcmp(argv[i], "--dynamic") == 0)
+                isDynamic = true;
+            else
+                isValid = false;
+        }
+        if (!isValid) {
+            std::cerr << "Usage: " << argv[0] << " [--threads N] < tree" << std::endl
+                      << "       " << argv[0] << " --dynamic < commands" << std::endl
+                      << "       " << argv[0] << " --benchmark NODECOUNT" << std::endl;
+            return 1;
+        }
+        if (benchmarkNodeCount > 1) {
+            RunBenchmark(benchmarkNodeCount);
+            return 0;
+        }
+        InputReader reader;
+        OutputWriter writer;
+        if (isDynamic) {
+            RunCommands(reader, writer);
+            writer.Flush();
+            return 0;
+        }
+        SetParallelism(threadCount);
+        int32_t nodeCount = 0;
+        reader >> nodeCount;
+        std::vector<int32_t> edgeEnds(2 * static_cast<size_t>(std::max(nodeCount - 1, 0)));
+        for (int32_t& end : edgeEnds)
+            reader >> end;
+        if (nodeCount <= 0)
+            return 0;
+        std::vector<int32_t> lengths;
+        {
+            Tree tree = GetTree(nodeCount, std::move(edgeEnds));
+            lengths = GetLengthsToFurthestPeak(tree, GetHeights(tree));
+        }
+        for (int32_t length : lengths)
+            writer << length << '\n';
+        writer.Flush();
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
@@ -1,43 +1,114 @@
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
-#include <vector>
+#include <utility>
+#include "../Common/fast_io.h"
 
-void OverflowHandling(std::vector<uint32_t>& sum, bool& isOverflow, int32_t i) {
-    isOverflow = sum[i] >= 10;
-    sum[i] %= 10;
+// Eight decimal places per 64-bit word, one digit (0..9) per byte with the lowest place in the lowest byte.
+const uint64_t asciiZeros = 0x3030303030303030ULL;
+const uint64_t highNibbles = 0xF0F0F0F0F0F0F0F0ULL;
+const uint64_t lowBytes = 0x0101010101010101ULL;
+
+// The 8 places of a decimal string that end `place` digits from its right, padded with zeros on the left.
+uint64_t LoadPlaces(const char* digits, const size_t& length, const size_t& place) {
+    char chunk[8];
+    if (place + 8 <= length)
+        std::memcpy(chunk, digits + length - place - 8, 8);
+    else {
+        size_t count = (place < length ? length - place : 0);
+        std::memset(chunk, '0', 8 - count);
+        if (count > 0)
+            std::memcpy(chunk + 8 - count, digits + length - place - count, count);
+    }
+    uint64_t word;
+    std::memcpy(&word, chunk, 8);
+    word = __builtin_bswap64(word);
+    // '0'..'9' are exactly the bytes 0x3N that stay 0x3N when 6 is added.
+    if ((word & highNibbles) != asciiZeros || ((word + 6 * lowBytes) & highNibbles) != asciiZeros)
+        throw std::runtime_error("Operands must consist of decimal digits.");
+    return word - asciiZeros;
 }
 
-std::string GetSum(std::string bigUInt1, std::string bigUInt2) {
-    std::string sumStr;
-    std::vector<std::uint32_t> sum;
-    bool isOverflow = false;
-    std::reverse(bigUInt1.begin(), bigUInt1.end());
-    std::reverse(bigUInt2.begin(), bigUInt2.end());
-    if (bigUInt1.length() > bigUInt2.length())
-        std::swap(bigUInt1, bigUInt2);
-    uint32_t i = 0;
-    for (; i < bigUInt1.length(); ++i) {
-        sum.push_back((bigUInt1[i] - '0') + (bigUInt2[i] - '0') + (isOverflow ? 1 : 0));
-        OverflowHandling(sum, isOverflow, i);
+// a + b + carry on 8 places at once. Every byte of a is biased by 0xF6 so that it overflows into the next byte exactly
+// when the decimal place does, which lets the word addition ripple the decimal carries; a byte that did not overflow
+// is left with its bias (and its top bit set) and loses it afterwards.
+uint64_t AddPlaces(const uint64_t& a, const uint64_t& b, bool& carry) {
+    uint64_t biased = a + 0xF6 * lowBytes;
+    uint64_t sum = biased + b;
+    bool isOverflow = sum < biased;
+    uint64_t total = sum + carry;
+    carry = isOverflow || total < sum;
+    return total - ((total >> 7) & lowBytes) * 0xF6;
+}
+
+// Writes the sum of two decimal strings right-aligned into sum, which must hold max(length1, length2) + 1 characters,
+// and returns the index of its first digit: 0 if the sum is one digit longer than the longer operand, 1 otherwise.
+// Leading zeros of the operands are kept, as digits of the longer one.
+size_t GetSum(const char* digits1, size_t length1, const char* digits2, size_t length2, char* sum) {
+    if (length1 < length2) {
+        std::swap(digits1, digits2);
+        std::swap(length1, length2);
     }
-    for (; i < bigUInt2.length(); ++i) {
-        sum.push_back((bigUInt2[i] - '0') + (isOverflow ? 1 : 0));
-        OverflowHandling(sum, isOverflow, i);
+    char* end = sum + length1 + 1;
+    bool carry = false;
+    for (size_t place = 0; place < length1; place += 8) {
+        uint64_t word = AddPlaces(LoadPlaces(digits1, length1, place), LoadPlaces(digits2, length2, place), carry);
+        word = __builtin_bswap64(word + asciiZeros);
+        size_t count = std::min<size_t>(8, length1 - place);
+        char chunk[8];
+        std::memcpy(chunk, &word, 8);
+        std::memcpy(end - place - count, chunk + 8 - count, count);
+        // In a partial chunk the carry out of the top place lands in the padding instead of leaving the word.
+        if (count < 8)
+            carry = chunk[7 - count] != '0';
     }
-    if (isOverflow)
-        sum.push_back(1);
-    for (uint32_t iDigit : sum)
-        sumStr += std::to_string(iDigit);
-    std::reverse(sumStr.begin(), sumStr.end());
-    return sumStr;
+    sum[0] = '1';
+    return (carry ? 0 : 1);
 }
 
-int main() {
-    std::string bigUInt1 = "";
-    std::string bigUInt2 = "";
-    std::cin >> bigUInt1 >> bigUInt2;
-    std::cout << GetSum(bigUInt1, bigUInt2) << std::endl;
+// The operands come from the file given as the argument or from the standard input. A regular file is mapped and
+// added in place, so only the sum is ever allocated; piped input is read into two strings first.
+int main(int argc, char* argv[]) {
+    try {
+        if (argc > 2) {
+            std::cerr << "Usage: " << argv[0] << " [file]" << std::endl;
+            return 1;
+        }
+        int fileDescriptor = STDIN_FILENO;
+        if (argc == 2 && (fileDescriptor = open(argv[1], O_RDONLY)) < 0)
+            throw std::runtime_error(std::string("Cannot open ") + argv[1] + ".");
+        InputReader reader(fileDescriptor);
+        OutputWriter writer;
+        std::string bigUInt1 = "";
+        std::string bigUInt2 = "";
+        const char* digits1 = nullptr;
+        const char* digits2 = nullptr;
+        size_t length1 = 0;
+        size_t length2 = 0;
+        if (reader.IsMapped()) {
+            if (reader.ReadTokenInPlace(digits1, length1))
+                reader.ReadTokenInPlace(digits2, length2);
+        }
+        else {
+            reader >> bigUInt1 >> bigUInt2;
+            digits1 = bigUInt1.data();
+            length1 = bigUInt1.size();
+            digits2 = bigUInt2.data();
+            length2 = bigUInt2.size();
+        }
+        size_t sumSize = std::max(length1, length2) + 1;
+        std::unique_ptr<char[]> sum(new char[sumSize]);
+        size_t start = GetSum(digits1, length1, digits2, length2, sum.get());
+        writer.Write(sum.get() + start, sumSize - start);
+        writer << '\n';
+        writer.Flush();
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
@@ -1,9 +1,61 @@
+#ifndef BIGINTEGER_H
+#define BIGINTEGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
+#include "../Common/convolution.h"
+#include "../Common/fast_io.h"
+#include "../Common/thread_pool.h"
 
+// Little-endian limbs of a BigInteger magnitude. Up to inlineCapacity limbs are stored inside the object itself,
+// so values of a few machine words are created, copied and updated without touching the heap.
+class LimbVector {
+    public:
+        LimbVector() = default;
+        explicit LimbVector(const unsigned int&, const unsigned int& = 0);
+        LimbVector(const unsigned int*, const unsigned int*);
+        LimbVector(const LimbVector&);
+        LimbVector(LimbVector&&) noexcept;
+        ~LimbVector();
+        LimbVector& operator=(const LimbVector&);
+        LimbVector& operator=(LimbVector&&) noexcept;
+        unsigned int& operator[](const unsigned int&);
+        const unsigned int& operator[](const unsigned int&) const;
+        unsigned int size() const;
+        bool empty() const;
+        unsigned int* data();
+        const unsigned int* data() const;
+        unsigned int* begin();
+        unsigned int* end();
+        const unsigned int* begin() const;
+        const unsigned int* end() const;
+        unsigned int& back();
+        const unsigned int& back() const;
+        void push_back(unsigned int);
+        void pop_back();
+        void resize(const unsigned int&, const unsigned int& = 0);
+        void assign(const unsigned int&, const unsigned int&);
+        void reserve(const unsigned int&);
+        void insert(unsigned int*, const unsigned int&, const unsigned int&);
+        void swap(LimbVector&);
+    private:
+        static const unsigned int inlineCapacity = 4;
+        union {
+            unsigned int inlineLimbs[inlineCapacity];
+            unsigned int* heapLimbs;
+        };
+        unsigned int limbCount = 0;
+        unsigned int capacity = inlineCapacity;
+        void Release();
+};
 class BigInteger {
     public:
+        class Modulus;
         BigInteger() = default;
         BigInteger(const char*);
         BigInteger(const std::string&);
@@ -14,7 +66,8 @@ class BigInteger {
         BigInteger& operator*=(const BigInteger&);
         BigInteger& operator/=(const BigInteger&);
         BigInteger& operator%=(const BigInteger&);
-        BigInteger operator-() const;
+        BigInteger operator-() const&;
+        BigInteger operator-() &&;
         BigInteger& operator++();
         BigInteger operator++(int);
         BigInteger& operator--();
@@ -27,33 +80,285 @@ class BigInteger {
         friend bool operator!=(const BigInteger&, const BigInteger&);
         friend std::ostream& operator<<(std::ostream&, const BigInteger&);
         friend std::istream& operator>>(std::istream&, BigInteger&);
+        friend OutputWriter& operator<<(OutputWriter&, const BigInteger&);
+        friend InputReader& operator>>(InputReader&, BigInteger&);
+        friend void divmod(const BigInteger&, const BigInteger&, BigInteger&, BigInteger&);
+        friend void addmul(BigInteger&, const BigInteger&, const BigInteger&);
+        friend void submul(BigInteger&, const BigInteger&, const BigInteger&);
+        friend void mul_add_into(BigInteger&, const BigInteger&, const BigInteger&, const BigInteger&);
+        friend BigInteger operator*(const BigInteger&, const BigInteger&);
+        friend BigInteger mulmod(const BigInteger&, const BigInteger&, const BigInteger&);
+        friend BigInteger powmod(const BigInteger&, const BigInteger&, const BigInteger&);
+        friend BigInteger gcd(const BigInteger&, const BigInteger&);
+        friend BigInteger gcdext(const BigInteger&, const BigInteger&, BigInteger&, BigInteger&);
+        friend BigInteger modinv(const BigInteger&, const BigInteger&);
+        friend BigInteger isqrt(const BigInteger&);
+        friend BigInteger iroot(const BigInteger&, const unsigned int&);
         std::string toString() const;
+        // Opt-in parallel multiplication: with threadCount > 1, products whose shorter factor has at least grainSize
+        // limbs run their independent sub-products on a shared work-stealing pool. Division and radix conversion go
+        // through the same products. Must not be called while other threads are using BigInteger.
+        static void SetParallelism(unsigned int, const unsigned int& = defaultGrainSize);
     private:
-        std::vector<unsigned int> digits = {0};
+        struct ScratchArena;
+        class ScratchFrame;
+        LimbVector digits = LimbVector(1, 0);
         bool isNegative = false;
-        static const unsigned int base = 10;
-        static std::vector<unsigned int> GetVectorSum(const std::vector<unsigned int>&, const std::vector<unsigned int>&, const bool& isInRightOrder);
-        static std::vector<unsigned int> GetVectorDifference(const std::vector<unsigned int>&, const std::vector<unsigned int>&);
-        static std::vector<unsigned int> GetVectorProduct(const std::vector<unsigned int>&, const std::vector<unsigned int>&);
-        static std::vector<unsigned int> GetVectorQuotient(const std::vector<unsigned int>&, const std::vector<unsigned int>&);
-        static std::vector<unsigned int> GetVectorRemainder(const std::vector<unsigned int>&, const std::vector<unsigned int>&);
-        static char GetVectorCompareResult(const std::vector<unsigned int>&, const std::vector<unsigned int>&);
-        static void DeleteLeadingZeros(std::vector<unsigned int>&);
-        static std::vector<unsigned int> GetVectorProduct(const std::vector<unsigned int>&, const unsigned int&, const unsigned int&);
-        static void Add(std::vector<unsigned int>&, const unsigned int&, const unsigned int&);
-        static void PushBackVector(std::vector<unsigned int>&, const std::vector<unsigned int>&, const unsigned int&);
-        static unsigned int GetTwoPower(const unsigned int&);
-        static std::vector<unsigned int> GetVectorProduct(const std::vector<unsigned int>&, const std::vector<unsigned int>&, const bool&);
+        static const unsigned int baseBits = 32;
+        static const unsigned int decimalBase = 1000000000;
+        static const unsigned int decimalBaseLength = 9;
+        // Operand sizes (in limbs of the shorter factor) at which GetVectorProduct switches algorithm.
+        static const unsigned int karatsubaThreshold = 32;
+        static const unsigned int fftThreshold = 160;
+        // Divisor size (in limbs) from which division goes through a Newton-Raphson reciprocal instead of Algorithm D.
+        static const unsigned int newtonThreshold = 2000;
+        static const unsigned int reciprocalThreshold = 200;
+        // Number of limbs (or decimal groups) below which radix conversion is done by the quadratic method.
+        static const unsigned int decimalConversionThreshold = 64;
+        static const unsigned int defaultGrainSize = 1024;
+        // Modulus size (in limbs) from which Montgomery reduction is done with whole products instead of word by word.
+        static const unsigned int montgomeryThreshold = 128;
+        BigInteger& AddWithSign(const BigInteger&, const bool&);
+        void AddLimbsWithSign(const unsigned int*, const unsigned int&, const bool&);
+        BigInteger& AddProduct(const BigInteger&, const BigInteger&, const bool&);
+        BigInteger& AddUnit(const bool&);
+        static LimbVector GetVectorProduct(const LimbVector&, const LimbVector&);
+        static unsigned int AddLimbs(unsigned int*, const unsigned int*, const unsigned int&, const unsigned int*, const unsigned int&);
+        static unsigned int SubtractLimbs(unsigned int*, const unsigned int*, const unsigned int&, const unsigned int*, const unsigned int&);
+        static std::atomic<unsigned int>& GetGrainSize();
+        static bool IsParallelProduct(const unsigned int&);
+        static bool AddSignedLimbs(unsigned int*, const unsigned int*, const bool&, const unsigned int*, const bool&, const unsigned int&);
+        static char CompareLimbs(const unsigned int*, const unsigned int*, const unsigned int&);
+        static unsigned int DivideLimbs(unsigned int*, const unsigned int&, const unsigned int&);
+        static void ShiftRightLimbs(unsigned int*, const unsigned int&, const unsigned int&);
+        static void MultiplyLimbs(unsigned int*, const unsigned int*, unsigned int, const unsigned int*, unsigned int);
+        static void MultiplySchoolbook(unsigned int*, const unsigned int*, const unsigned int&, const unsigned int*, const unsigned int&);
+        static void MultiplyKaratsuba(unsigned int*, const unsigned int*, const unsigned int&, const unsigned int*, const unsigned int&);
+        static void MultiplyUnbalanced(unsigned int*, const unsigned int*, const unsigned int&, const unsigned int*, const unsigned int&);
+        static void DivideVectors(const LimbVector&, const LimbVector&, LimbVector&, LimbVector&, const LimbVector* = nullptr);
+        static void DivideVectorsKnuth(const LimbVector&, const LimbVector&, LimbVector&, LimbVector&);
+        static void DivideVectorsNewton(const LimbVector&, const LimbVector&, const LimbVector&, LimbVector&, LimbVector&);
+        static LimbVector GetVectorReciprocal(const LimbVector&);
+        static char GetVectorCompareResult(const LimbVector&, const LimbVector&);
+        static void DeleteLeadingZeros(LimbVector&);
+        static void PushBackVector(LimbVector&, const LimbVector&, const unsigned int&);
+        static void ShiftLeft(LimbVector&, const unsigned int&);
+        static void ShiftRight(LimbVector&, const unsigned int&);
+        static unsigned int GetLeadingZeroCount(unsigned int);
+        static unsigned int DivideVector(LimbVector&, const unsigned int&);
+        static void MultiplyAddVector(LimbVector&, const unsigned int&, const unsigned int&);
+        static const LimbVector& GetDecimalPower(const unsigned int&);
+        static const LimbVector& GetDecimalPowerReciprocal(const unsigned int&);
+        static LimbVector GetVectorFromDecimalGroups(const std::vector<unsigned int>&, const unsigned int&, const unsigned int&);
+        static void AppendDecimalGroups(const LimbVector&, const unsigned int&, std::vector<unsigned int>&);
+        template<typename Source>
+        static bool ReadDecimal(Source&, BigInteger&);
+        static LimbVector GetVectorPart(const LimbVector&, const unsigned int&, const unsigned int&);
+        static BigInteger GetPart(const LimbVector&, const unsigned int&, const unsigned int&);
+        static LimbVector GetVectorGcd(LimbVector, LimbVector, BigInteger*);
+        static void CombineVectors(LimbVector&, LimbVector&, const long long&, const long long&, const long long&, const long long&);
+        static BigInteger GetScaled(const BigInteger&, const long long&);
+        static BigInteger GetFromWord(const unsigned long long&);
+        static unsigned int GetBitLength(const LimbVector&);
+        static void ShiftLeftBits(LimbVector&, const unsigned int&);
+        static void ShiftRightBits(LimbVector&, const unsigned int&);
+        static BigInteger GetPower(BigInteger, unsigned int);
+        static BigInteger GetRoot(const BigInteger&, const unsigned int&);
 };
-BigInteger::operator bool() const {
-    return *this != BigInteger();
+const unsigned int LimbVector::inlineCapacity;
+const unsigned int BigInteger::baseBits;
+const unsigned int BigInteger::decimalBase;
+const unsigned int BigInteger::decimalBaseLength;
+const unsigned int BigInteger::karatsubaThreshold;
+const unsigned int BigInteger::fftThreshold;
+const unsigned int BigInteger::newtonThreshold;
+const unsigned int BigInteger::reciprocalThreshold;
+const unsigned int BigInteger::decimalConversionThreshold;
+const unsigned int BigInteger::defaultGrainSize;
+const unsigned int BigInteger::montgomeryThreshold;
+// Per-thread stack of scratch limbs used by the multiplication kernels. Blocks are never moved or freed, so
+// pointers into them stay valid; everything past the current position is free and may be reused or regrown.
+struct BigInteger::ScratchArena {
+    std::vector<std::vector<unsigned int>> blocks;
+    unsigned int blockIndex = 0;
+    unsigned int offset = 0;
+    static ScratchArena& GetInstance();
+};
+// Allocations made through a frame are released when the frame goes out of scope, so frames must nest.
+class BigInteger::ScratchFrame {
+    public:
+        ScratchFrame();
+        ~ScratchFrame();
+        ScratchFrame(const ScratchFrame&) = delete;
+        ScratchFrame& operator=(const ScratchFrame&) = delete;
+        unsigned int* Allocate(const unsigned int&);
+    private:
+        ScratchArena& arena;
+        unsigned int blockIndex;
+        unsigned int offset;
+};
+// Reduction context for a fixed modulus m > 0 of n limbs. Single products are reduced with Barrett's method; powers
+// keep their residues (exactly n limbs) in Montgomery form x * B^n mod m when m is odd. Once the context is built,
+// products and powers of operands in [0, m) never go through general division. Results are always in [0, m).
+class BigInteger::Modulus {
+    public:
+        explicit Modulus(const BigInteger&);
+        const BigInteger& GetValue() const;
+        BigInteger Reduce(const BigInteger&) const;
+        BigInteger Multiply(const BigInteger&, const BigInteger&) const;
+        BigInteger Power(const BigInteger&, const BigInteger&) const;
+    private:
+        BigInteger value;
+        unsigned int size;
+        bool isMontgomery;
+        // Montgomery (odd m only): -m^-1 mod B, -m^-1 mod B^n and B^2n mod m. Barrett: floor(B^2n / m).
+        unsigned int inverse = 0;
+        LimbVector fullInverse;
+        LimbVector montgomerySquare;
+        LimbVector reciprocal;
+        LimbVector ToResidue(const BigInteger&) const;
+        BigInteger FromResidue(const LimbVector&) const;
+        void MultiplyResidues(unsigned int*, const unsigned int*, const unsigned int*) const;
+        void ReduceMontgomery(unsigned int*, unsigned int*) const;
+        void ReduceBarrett(unsigned int*, unsigned int*) const;
+};
+BigInteger mulmod(const BigInteger&, const BigInteger&, const BigInteger::Modulus&);
+BigInteger powmod(const BigInteger&, const BigInteger&, const BigInteger::Modulus&);
+BigInteger operator+(const BigInteger&, const BigInteger&);
+BigInteger operator-(const BigInteger&, const BigInteger&);
+BigInteger operator*(const BigInteger&, const BigInteger&);
+BigInteger operator/(const BigInteger&, const BigInteger&);
+BigInteger operator%(const BigInteger&, const BigInteger&);
+BigInteger operator+(BigInteger&&, const BigInteger&);
+BigInteger operator+(const BigInteger&, BigInteger&&);
+BigInteger operator+(BigInteger&&, BigInteger&&);
+BigInteger operator-(BigInteger&&, const BigInteger&);
+BigInteger operator-(const BigInteger&, BigInteger&&);
+BigInteger operator-(BigInteger&&, BigInteger&&);
+LimbVector::LimbVector(const unsigned int& size, const unsigned int& value) {
+    resize(size, value);
 }
-BigInteger::BigInteger(const char* num) : digits(std::vector<unsigned int>(0)) {
-    if ((((num[0] == '-') || (num[0] == '+')) && (num[1] == '0')) || (num[0] == '0')) {
-        digits.push_back(0);
-        isNegative = false;
-        return;
+LimbVector::LimbVector(const unsigned int* first, const unsigned int* last) {
+    reserve(last - first);
+    std::copy(first, last, data());
+    limbCount = last - first;
+}
+LimbVector::LimbVector(const LimbVector& limbs) : LimbVector(limbs.begin(), limbs.end()) {}
+LimbVector::LimbVector(LimbVector&& limbs) noexcept {
+    *this = std::move(limbs);
+}
+LimbVector::~LimbVector() {
+    Release();
+}
+LimbVector& LimbVector::operator=(const LimbVector& limbs) {
+    if (this != &limbs) {
+        limbCount = 0;
+        reserve(limbs.limbCount);
+        std::copy(limbs.begin(), limbs.end(), data());
+        limbCount = limbs.limbCount;
     }
+    return *this;
+}
+LimbVector& LimbVector::operator=(LimbVector&& limbs) noexcept {
+    if (this == &limbs)
+        return *this;
+    Release();
+    if (limbs.capacity > inlineCapacity) {
+        heapLimbs = limbs.heapLimbs;
+        capacity = limbs.capacity;
+        limbs.capacity = inlineCapacity;
+    }
+    else
+        std::copy(limbs.inlineLimbs, limbs.inlineLimbs + limbs.limbCount, inlineLimbs);
+    limbCount = limbs.limbCount;
+    limbs.limbCount = 0;
+    return *this;
+}
+unsigned int& LimbVector::operator[](const unsigned int& index) {
+    return data()[index];
+}
+const unsigned int& LimbVector::operator[](const unsigned int& index) const {
+    return data()[index];
+}
+unsigned int LimbVector::size() const {
+    return limbCount;
+}
+bool LimbVector::empty() const {
+    return limbCount == 0;
+}
+unsigned int* LimbVector::data() {
+    return (capacity > inlineCapacity ? heapLimbs : inlineLimbs);
+}
+const unsigned int* LimbVector::data() const {
+    return (capacity > inlineCapacity ? heapLimbs : inlineLimbs);
+}
+unsigned int* LimbVector::begin() {
+    return data();
+}
+unsigned int* LimbVector::end() {
+    return data() + limbCount;
+}
+const unsigned int* LimbVector::begin() const {
+    return data();
+}
+const unsigned int* LimbVector::end() const {
+    return data() + limbCount;
+}
+unsigned int& LimbVector::back() {
+    return data()[limbCount - 1];
+}
+const unsigned int& LimbVector::back() const {
+    return data()[limbCount - 1];
+}
+void LimbVector::push_back(unsigned int value) {
+    if (limbCount == capacity)
+        reserve(2 * capacity);
+    data()[limbCount++] = value;
+}
+void LimbVector::pop_back() {
+    --limbCount;
+}
+void LimbVector::resize(const unsigned int& size, const unsigned int& value) {
+    reserve(size);
+    if (size > limbCount)
+        std::fill(data() + limbCount, data() + size, value);
+    limbCount = size;
+}
+void LimbVector::assign(const unsigned int& size, const unsigned int& value) {
+    limbCount = 0;
+    resize(size, value);
+}
+void LimbVector::reserve(const unsigned int& size) {
+    if (size <= capacity)
+        return;
+    unsigned int newCapacity = std::max(size, capacity + capacity / 2);
+    unsigned int* newLimbs = new unsigned int[newCapacity];
+    std::copy(begin(), end(), newLimbs);
+    Release();
+    heapLimbs = newLimbs;
+    capacity = newCapacity;
+}
+void LimbVector::insert(unsigned int* position, const unsigned int& count, const unsigned int& value) {
+    unsigned int index = position - data();
+    reserve(limbCount + count);
+    std::copy_backward(data() + index, data() + limbCount, data() + limbCount + count);
+    std::fill(data() + index, data() + index + count, value);
+    limbCount += count;
+}
+void LimbVector::swap(LimbVector& limbs) {
+    LimbVector limbsCopy = std::move(limbs);
+    limbs = std::move(*this);
+    *this = std::move(limbsCopy);
+}
+void LimbVector::Release() {
+    if (capacity > inlineCapacity)
+        delete[] heapLimbs;
+    capacity = inlineCapacity;
+}
+BigInteger::operator bool() const {
+    return (digits.size() > 1) || (digits[0] != 0);
+}
+BigInteger::BigInteger(const char* num) {
     bool isStartFrom1 = false;
     switch (num[0]) {
         case '-':
@@ -63,33 +368,31 @@ BigInteger::BigInteger(const char* num) : digits(std::vector<unsigned int>(0)) {
         case '+':
             isStartFrom1 = true;
     }
-    for (unsigned int i = (isStartFrom1 ? 1 : 0); num[i] != '\0'; ++i)
-        digits.push_back(num[i] - '0');
-    for (unsigned int i = 0; i < digits.size() / 2; ++i) {
-        unsigned int temp = digits[i];
-        digits[i] = digits[digits.size() - 1 - i];
-        digits[digits.size() - 1 - i] = temp;
-    }
+    unsigned int i = (isStartFrom1 ? 1 : 0);
+    while (num[i] == '0')
+        ++i;
+    unsigned int length = 0;
+    while (num[i + length] != '\0')
+        ++length;
+    std::vector<unsigned int> groups((length + decimalBaseLength - 1) / decimalBaseLength);
+    unsigned int groupLength = (length % decimalBaseLength == 0 ? decimalBaseLength : length % decimalBaseLength);
+    for (unsigned int end = i + length, j = groups.size() - 1; i < end; i += groupLength, groupLength = decimalBaseLength, --j)
+        for (unsigned int k = i; k < i + groupLength; ++k)
+            groups[j] = groups[j] * 10 + (num[k] - '0');
+    digits = GetVectorFromDecimalGroups(groups, 0, groups.size());
+    if ((digits.size() == 1) && (digits[0] == 0))
+        isNegative = false;
 }
 BigInteger::BigInteger(const std::string& num) : BigInteger(&num[0]) {}
-BigInteger::BigInteger(int num) : digits(0) {
-    if (num == 0) {
-        isNegative = false;
-        digits.push_back(0);
-        return;
-    }
+BigInteger::BigInteger(int num) : digits(1, 0) {
     isNegative = num < 0;
-    num = (isNegative ? -num : num);
-    while (num != 0) {
-        digits.push_back(num % base);
-        num /= base;
-    }
+    digits[0] = (isNegative ? 0u - static_cast<unsigned int>(num) : static_cast<unsigned int>(num));
 }
-void BigInteger::DeleteLeadingZeros(std::vector<unsigned int>& digits) {
+void BigInteger::DeleteLeadingZeros(LimbVector& digits) {
     while ((digits.size() > 1) && (digits[digits.size() - 1] == 0))
         digits.pop_back();
 }
-char BigInteger::GetVectorCompareResult(const std::vector<unsigned int>& digits1, const std::vector<unsigned int>& digits2) {
+char BigInteger::GetVectorCompareResult(const LimbVector& digits1, const LimbVector& digits2) {
     if (digits1.size() < digits2.size())
         return -1;
     if (digits2.size() < digits1.size())
@@ -114,208 +417,551 @@ bool operator>(const BigInteger& bigInt1, const BigInteger& bigInt2) {
     return bigInt2 < bigInt1;
 }
 bool operator==(const BigInteger& bigInt1, const BigInteger& bigInt2) {
-    return !((bigInt1 < bigInt2) || (bigInt1 > bigInt2));
+    return (bigInt1.isNegative == bigInt2.isNegative) && (BigInteger::GetVectorCompareResult(bigInt1.digits, bigInt2.digits) == 0);
 }
 bool operator!=(const BigInteger& bigInt1, const BigInteger& bigInt2) {
     return !(bigInt1 == bigInt2);
 }
 bool operator<=(const BigInteger& bigInt1, const BigInteger& bigInt2) {
-    return (bigInt1 < bigInt2) || (bigInt1 == bigInt2);
+    return !(bigInt2 < bigInt1);
 }
 bool operator>=(const BigInteger& bigInt1, const BigInteger& bigInt2) {
-    return (bigInt1 > bigInt2) || (bigInt1 == bigInt2);
+    return !(bigInt1 < bigInt2);
 }
-std::vector<unsigned int> BigInteger::GetVectorSum(const std::vector<unsigned int>& digits1, const std::vector<unsigned int>& digits2, const bool& isInRightOrder) {
-    if (isInRightOrder) {
-        std::vector<unsigned int> result;
-        bool isOverflow = false;
-        unsigned int i = 0;
-        for (; i < digits1.size(); ++i) {
-            unsigned int iSum = static_cast<unsigned int>(digits1[i]) + digits2[i] + (isOverflow ? 1 : 0);
-            isOverflow = iSum >= base;
-            iSum %= base;
-            result.push_back(iSum);
-        }
-        for (; i < digits2.size(); ++i) {
-            unsigned int iSum = digits2[i] + (isOverflow ? 1 : 0);
-            isOverflow = iSum >= base;
-            iSum %= base;
-            result.push_back(iSum);
-        }
-        if (isOverflow)
-            result.push_back(1);
-        DeleteLeadingZeros(result);
-        return result;
-    } 
-    else {
-        if (digits1.size() < digits2.size())
-            return GetVectorSum(digits1, digits2, true);
-        else
-            return GetVectorSum(digits2, digits1, true);
-    }
+BigInteger::ScratchArena& BigInteger::ScratchArena::GetInstance() {
+    static thread_local ScratchArena arena;
+    return arena;
 }
-std::vector<unsigned int> BigInteger::GetVectorDifference(const std::vector<unsigned int>& digits1, const std::vector<unsigned int>& digits2) {
-    std::vector<unsigned int> result = digits1;
-    std::vector<unsigned int> digits2Copy = digits2;
-    bool isTakeNext = false;
-    for (unsigned int i = 0; i < digits1.size() - digits2.size(); ++i)
-        digits2Copy.push_back(0);
-    for (unsigned int i = 0; i < digits1.size(); ++i) {
-        long long iDifference = static_cast<long long>(result[i]) - static_cast<long long>(digits2Copy[i]) - (isTakeNext ? 1 : 0);
-        if (iDifference < 0) {
-            isTakeNext = true;
-            iDifference += base;
-        } else
-            isTakeNext = false;
-        result[i] = iDifference;
+BigInteger::ScratchFrame::ScratchFrame() : arena(ScratchArena::GetInstance()), blockIndex(arena.blockIndex), offset(arena.offset) {}
+BigInteger::ScratchFrame::~ScratchFrame() {
+    arena.blockIndex = blockIndex;
+    arena.offset = offset;
+}
+unsigned int* BigInteger::ScratchFrame::Allocate(const unsigned int& size) {
+    if (arena.blocks.empty() || (arena.offset + size > arena.blocks[arena.blockIndex].size())) {
+        if (!arena.blocks.empty())
+            ++arena.blockIndex;
+        arena.offset = 0;
+        if (arena.blockIndex == arena.blocks.size())
+            arena.blocks.emplace_back();
+        std::vector<unsigned int>& block = arena.blocks[arena.blockIndex];
+        if (block.size() < size)
+            block.resize(std::max<unsigned int>(size, std::max<unsigned int>(1 << 16, 2 * block.size())));
     }
-    DeleteLeadingZeros(result);
+    unsigned int* result = arena.blocks[arena.blockIndex].data() + arena.offset;
+    arena.offset += size;
     return result;
 }
-std::vector<unsigned int> BigInteger::GetVectorProduct(const std::vector<unsigned int>& digits1, const std::vector<unsigned int>& digits2) {
-    unsigned int maxSize = GetTwoPower(std::max(digits1.size(), digits2.size()));
-    std::vector<unsigned int> digits1Copy = digits1;
-    std::vector<unsigned int> digits2Copy = digits2;
-    for (unsigned int i = 0; i < maxSize - digits1.size(); ++i)
-        digits1Copy.push_back(0);
-    for (unsigned int i = 0; i < maxSize - digits2.size(); ++i)
-        digits2Copy.push_back(0);
-    std::vector<unsigned int> result = GetVectorProduct(digits1Copy, digits2Copy, true);
-    for (unsigned int i = result.size() - 1; i != static_cast<unsigned int>(-1); --i)
-        for (unsigned int j = i; j < result.size(); ++j)
-            if (result[j] >= base) {
-                if (j + 1 == result.size())
-                    result.push_back(0);
-                result[j + 1] += result[j] / base;
-                result[j] %= base;
-            }
-            else
-                break;
+std::atomic<unsigned int>& BigInteger::GetGrainSize() {
+    static std::atomic<unsigned int> grainSize(defaultGrainSize);
+    return grainSize;
+}
+// The pool is the shared one of Common/thread_pool.h, so the four-step transforms of the largest products run on the
+// same threads as the sub-products that start them.
+void BigInteger::SetParallelism(unsigned int threadCount, const unsigned int& grainSize) {
+    GetGrainSize() = std::max(grainSize, karatsubaThreshold);
+    ::SetParallelism(threadCount);
+}
+bool BigInteger::IsParallelProduct(const unsigned int& size) {
+    return ThreadPool::GetInstance() && (size >= GetGrainSize());
+}
+LimbVector BigInteger::GetVectorProduct(const LimbVector& digits1, const LimbVector& digits2) {
+    LimbVector result(digits1.size() + digits2.size());
+    MultiplyLimbs(result.data(), digits1.data(), digits1.size(), digits2.data(), digits2.size());
     DeleteLeadingZeros(result);
     return result;
 }
-std::vector<unsigned int> BigInteger::GetVectorProduct(const std::vector<unsigned int>& digits1, const std::vector<unsigned int>& digits2, const bool&) {
-    std::vector<unsigned int> result;
-    unsigned int size = digits1.size();
-    if (size == 1) {
-        result.push_back(digits1[0] * digits2[0]);
-        return result;
+// result = digits1 + digits2 over size1 >= size2 limbs, returns the carry. result may alias either operand.
+unsigned int BigInteger::AddLimbs(unsigned int* result, const unsigned int* digits1, const unsigned int& size1, const unsigned int* digits2, const unsigned int& size2) {
+    unsigned long long carry = 0;
+    unsigned int i = 0;
+    for (; i < size2; ++i) {
+        carry += static_cast<unsigned long long>(digits1[i]) + digits2[i];
+        result[i] = static_cast<unsigned int>(carry);
+        carry >>= baseBits;
     }
-    std::vector<unsigned int> digits11;
-    std::vector<unsigned int> digits12;
-    std::vector<unsigned int> digits21;
-    std::vector<unsigned int> digits22;
-    for (unsigned int i = 0; i < size; ++i) {
-        if (i <= size / 2 - 1) {
-            digits11.push_back(digits1[i]);
-            digits21.push_back(digits2[i]);
+    for (; (i < size1) && (carry != 0); ++i) {
+        carry += digits1[i];
+        result[i] = static_cast<unsigned int>(carry);
+        carry >>= baseBits;
+    }
+    if (result != digits1)
+        std::copy(digits1 + i, digits1 + size1, result + i);
+    return static_cast<unsigned int>(carry);
+}
+// result = digits1 - digits2 over size1 >= size2 limbs, returns the borrow. result may alias either operand.
+unsigned int BigInteger::SubtractLimbs(unsigned int* result, const unsigned int* digits1, const unsigned int& size1, const unsigned int* digits2, const unsigned int& size2) {
+    bool isTakeNext = false;
+    unsigned int i = 0;
+    for (; i < size2; ++i) {
+        unsigned long long subtrahend = static_cast<unsigned long long>(digits2[i]) + (isTakeNext ? 1 : 0);
+        isTakeNext = digits1[i] < subtrahend;
+        result[i] = static_cast<unsigned int>(digits1[i] - subtrahend);
+    }
+    for (; (i < size1) && isTakeNext; ++i) {
+        isTakeNext = digits1[i] == 0;
+        result[i] = digits1[i] - 1;
+    }
+    if (result != digits1)
+        std::copy(digits1 + i, digits1 + size1, result + i);
+    return (isTakeNext ? 1 : 0);
+}
+// Sign-magnitude addition of two size-limb numbers, returns the sign of the result. result may alias either operand.
+bool BigInteger::AddSignedLimbs(unsigned int* result, const unsigned int* digits1, const bool& isNegative1, const unsigned int* digits2, const bool& isNegative2, const unsigned int& size) {
+    if (isNegative1 == isNegative2) {
+        AddLimbs(result, digits1, size, digits2, size);
+        return isNegative1;
+    }
+    char compareResult = CompareLimbs(digits1, digits2, size);
+    if (compareResult >= 0) {
+        SubtractLimbs(result, digits1, size, digits2, size);
+        return isNegative1 && (compareResult != 0);
+    }
+    SubtractLimbs(result, digits2, size, digits1, size);
+    return isNegative2;
+}
+char BigInteger::CompareLimbs(const unsigned int* digits1, const unsigned int* digits2, const unsigned int& size) {
+    for (unsigned int i = size - 1; i != static_cast<unsigned int>(-1); --i) {
+        if (digits1[i] < digits2[i])
+            return -1;
+        if (digits1[i] > digits2[i])
+            return 1;
+    }
+    return 0;
+}
+unsigned int BigInteger::DivideLimbs(unsigned int* digits, const unsigned int& size, const unsigned int& divisor) {
+    unsigned long long remainder = 0;
+    for (unsigned int i = size - 1; i != static_cast<unsigned int>(-1); --i) {
+        remainder = (remainder << baseBits) | digits[i];
+        digits[i] = static_cast<unsigned int>(remainder / divisor);
+        remainder %= divisor;
+    }
+    return static_cast<unsigned int>(remainder);
+}
+void BigInteger::ShiftRightLimbs(unsigned int* digits, const unsigned int& size, const unsigned int& shift) {
+    for (unsigned int i = 0; i + 1 < size; ++i)
+        digits[i] = (digits[i] >> shift) | (digits[i + 1] << (baseBits - shift));
+    digits[size - 1] >>= shift;
+}
+// result (size1 + size2 limbs, must not overlap the operands) = digits1 * digits2. Chooses the algorithm by the
+// length of the shorter operand; temporaries come from the thread's ScratchArena.
+void BigInteger::MultiplyLimbs(unsigned int* result, const unsigned int* digits1, unsigned int size1, const unsigned int* digits2, unsigned int size2) {
+    unsigned int resultSize = size1 + size2;
+    while ((size1 > 0) && (digits1[size1 - 1] == 0))
+        --size1;
+    while ((size2 > 0) && (digits2[size2 - 1] == 0))
+        --size2;
+    std::fill(result + size1 + size2, result + resultSize, 0);
+    if (size1 < size2) {
+        std::swap(digits1, digits2);
+        std::swap(size1, size2);
+    }
+    if (size2 == 0)
+        std::fill(result, result + size1, 0);
+    else if (size2 < karatsubaThreshold)
+        MultiplySchoolbook(result, digits1, size1, digits2, size2);
+    else if (2 * size2 <= size1)
+        MultiplyUnbalanced(result, digits1, size1, digits2, size2);
+    else if (size2 < fftThreshold)
+        MultiplyKaratsuba(result, digits1, size1, digits2, size2);
+    else
+        MultiplyIntegers(result, digits1, size1, digits2, size2);
+}
+// A square (same operand twice) adds each cross product once, doubles the sum and then adds the diagonal.
+void BigInteger::MultiplySchoolbook(unsigned int* result, const unsigned int* digits1, const unsigned int& size1, const unsigned int* digits2, const unsigned int& size2) {
+    std::fill(result, result + size1 + size2, 0);
+    if ((digits1 == digits2) && (size1 == size2)) {
+        for (unsigned int i = 0; i + 1 < size1; ++i) {
+            unsigned long long carry = 0;
+            for (unsigned int j = i + 1; j < size1; ++j) {
+                carry += static_cast<unsigned long long>(digits1[i]) * digits1[j] + result[i + j];
+                result[i + j] = static_cast<unsigned int>(carry);
+                carry >>= baseBits;
+            }
+            result[i + size1] = static_cast<unsigned int>(carry);
         }
-        else {
-            digits12.push_back(digits1[i]);
-            digits22.push_back(digits2[i]);
+        AddLimbs(result, result, 2 * size1, result, 2 * size1);
+        unsigned long long carry = 0;
+        for (unsigned int i = 0; i < size1; ++i) {
+            unsigned long long square = static_cast<unsigned long long>(digits1[i]) * digits1[i];
+            carry += static_cast<unsigned long long>(result[2 * i]) + static_cast<unsigned int>(square);
+            result[2 * i] = static_cast<unsigned int>(carry);
+            carry >>= baseBits;
+            carry += static_cast<unsigned long long>(result[2 * i + 1]) + (square >> baseBits);
+            result[2 * i + 1] = static_cast<unsigned int>(carry);
+            carry >>= baseBits;
         }
+        return;
     }
-    std::vector<unsigned int> result0 = GetVectorProduct(GetVectorSum(digits11, digits12, false), GetVectorSum(digits21, digits22, false));
-    std::vector<unsigned int> result1 = GetVectorProduct(digits11, digits21);
-    std::vector<unsigned int> result3 = GetVectorProduct(digits12, digits22);
-    std::vector<unsigned int> result2 = GetVectorDifference(result0, GetVectorSum(result1, result3, false));
-    PushBackVector(result, result1, 0);
-    PushBackVector(result, result2, size / 2);
-    PushBackVector(result, result3, size);
+    for (unsigned int i = 0; i < size2; ++i) {
+        unsigned long long carry = 0;
+        for (unsigned int j = 0; j < size1; ++j) {
+            carry += static_cast<unsigned long long>(digits1[j]) * digits2[i] + result[i + j];
+            result[i + j] = static_cast<unsigned int>(carry);
+            carry >>= baseBits;
+        }
+        result[i + size1] = static_cast<unsigned int>(carry);
+    }
+}
+// size1 >= size2 > size1 / 2, so both operands split into a low half of size1 / 2 limbs and a non-empty high half.
+void BigInteger::MultiplyKaratsuba(unsigned int* result, const unsigned int* digits1, const unsigned int& size1, const unsigned int* digits2, const unsigned int& size2) {
+    ScratchFrame frame;
+    unsigned int size = size1 / 2;
+    unsigned int highSize1 = size1 - size;
+    unsigned int highSize2 = size2 - size;
+    unsigned int sumSize1 = highSize1 + 1;
+    unsigned int sumSize2 = std::max(size, highSize2) + 1;
+    bool isSquare = (digits1 == digits2) && (size1 == size2);
+    unsigned int* sum1 = frame.Allocate(sumSize1);
+    unsigned int* sum2 = (isSquare ? sum1 : frame.Allocate(sumSize2));
+    unsigned int* middle = frame.Allocate(sumSize1 + sumSize2);
+    sum1[highSize1] = AddLimbs(sum1, digits1 + size, highSize1, digits1, size);
+    if (!isSquare && (highSize2 >= size))
+        sum2[sumSize2 - 1] = AddLimbs(sum2, digits2 + size, highSize2, digits2, size);
+    else if (!isSquare)
+        sum2[sumSize2 - 1] = AddLimbs(sum2, digits2, size, digits2 + size, highSize2);
+    TaskGroup group(IsParallelProduct(size));
+    group.Run([=] { MultiplyLimbs(middle, sum1, sumSize1, sum2, sumSize2); });
+    group.Run([=] { MultiplyLimbs(result, digits1, size, digits2, size); });
+    MultiplyLimbs(result + 2 * size, digits1 + size, highSize1, digits2 + size, highSize2);
+    group.Wait();
+    SubtractLimbs(middle, middle, sumSize1 + sumSize2, result, 2 * size);
+    SubtractLimbs(middle, middle, sumSize1 + sumSize2, result + 2 * size, highSize1 + highSize2);
+    unsigned int restSize = size1 + size2 - size;
+    AddLimbs(result + size, result + size, restSize, middle, std::min(sumSize1 + sumSize2, restSize));
+}
+// Splits the longer factor into pieces as long as the shorter one, so every partial product is balanced.
+void BigInteger::MultiplyUnbalanced(unsigned int* result, const unsigned int* digits1, const unsigned int& size1, const unsigned int* digits2, const unsigned int& size2) {
+    ScratchFrame frame;
+    bool isParallel = IsParallelProduct(size2);
+    unsigned int pieceCount = (size1 + size2 - 1) / size2;
+    unsigned int* products = frame.Allocate(2 * size2 * (isParallel ? pieceCount : 1));
+    std::fill(result, result + size1 + size2, 0);
+    if (isParallel) {
+        // Every piece gets its own product buffer; the sums into result stay sequential.
+        TaskGroup group(true);
+        for (unsigned int i = 0; i < size1; i += size2)
+            group.Run([=] { MultiplyLimbs(products + 2 * i, digits1 + i, std::min(size2, size1 - i), digits2, size2); });
+        group.Wait();
+    }
+    for (unsigned int i = 0; i < size1; i += size2) {
+        unsigned int pieceSize = std::min(size2, size1 - i);
+        unsigned int* product = products + (isParallel ? 2 * i : 0);
+        if (!isParallel)
+            MultiplyLimbs(product, digits1 + i, pieceSize, digits2, size2);
+        AddLimbs(result + i, result + i, size1 + size2 - i, product, pieceSize + size2);
+    }
+}
+LimbVector BigInteger::GetVectorPart(const LimbVector& digits, const unsigned int& from, const unsigned int& to) {
+    if (from >= std::min<unsigned int>(to, digits.size()))
+        return LimbVector(1, 0);
+    LimbVector result(digits.data() + from, digits.data() + std::min<unsigned int>(to, digits.size()));
+    DeleteLeadingZeros(result);
     return result;
 }
-std::vector<unsigned int> BigInteger::GetVectorProduct(const std::vector<unsigned int>& digits, const unsigned int& num, const unsigned int& power) {
-    std::vector<unsigned int> numV = {num};
-    std::vector<unsigned int> base = {0, 1};
-    for (unsigned int i = 0; i < power; ++i)
-        numV = GetVectorProduct(numV, base);
-    return GetVectorProduct(digits, numV);
+BigInteger BigInteger::GetPart(const LimbVector& digits, const unsigned int& from, const unsigned int& to) {
+    BigInteger result;
+    result.digits = GetVectorPart(digits, from, to);
+    return result;
 }
-std::vector<unsigned int> BigInteger::GetVectorQuotient(const std::vector<unsigned int>& digits1, const std::vector<unsigned int>& digits2) {
+void BigInteger::DivideVectors(const LimbVector& digits1, const LimbVector& digits2, LimbVector& quotient, LimbVector& remainder, const LimbVector* reciprocal) {
     if ((digits2.size() == 1) && (digits2[0] == 0))
         throw std::runtime_error("Divide by zero.");
-    if (digits1.size() < digits2.size())
-        return std::vector<unsigned int>(1, 0);
-    std::vector<unsigned int> digits1Copy = digits1;
-    std::vector<unsigned int> result(digits1.size() - digits2.size() + 1);
-    unsigned int i = result.size() - 1;
-    while (((digits1Copy.size() > digits2.size()) || ((digits1Copy.size() == digits2.size()) && (digits2[digits2.size() - 1] <= digits1Copy[digits1Copy.size() - 1]))) && (i != static_cast<unsigned int>(-1))) {
-        while (GetVectorCompareResult(GetVectorProduct(digits2, result[i], i), digits1Copy) <= 0)
-            ++result[i];
-        --result[i];
-        digits1Copy = GetVectorDifference(digits1Copy, GetVectorProduct(digits2, result[i], i));
-        --i;
+    if ((digits1.size() == 1) && (digits2.size() == 1)) {
+        unsigned int digit1 = digits1[0], digit2 = digits2[0];
+        quotient.assign(1, digit1 / digit2);
+        remainder.assign(1, digit1 % digit2);
+        return;
     }
-    DeleteLeadingZeros(result);
-    return result;
+    if (GetVectorCompareResult(digits1, digits2) < 0) {
+        quotient.assign(1, 0);
+        remainder = digits1;
+        return;
+    }
+    if (digits2.size() == 1) {
+        quotient = digits1;
+        remainder.assign(1, DivideVector(quotient, digits2[0]));
+        return;
+    }
+    unsigned int shift = GetLeadingZeroCount(digits2.back());
+    LimbVector dividend = digits1;
+    LimbVector divisor = digits2;
+    ShiftLeft(dividend, shift);
+    ShiftLeft(divisor, shift);
+    if (divisor.size() < newtonThreshold)
+        DivideVectorsKnuth(dividend, divisor, quotient, remainder);
+    else if (reciprocal != nullptr)
+        DivideVectorsNewton(dividend, divisor, *reciprocal, quotient, remainder);
+    else
+        DivideVectorsNewton(dividend, divisor, GetVectorReciprocal(divisor), quotient, remainder);
+    ShiftRight(remainder, shift);
 }
-std::vector<unsigned int> BigInteger::GetVectorRemainder(const std::vector<unsigned int>& digits1, const std::vector<unsigned int>& digits2) {
-    if (digits1.size() < digits2.size())
-        return digits1;
-    std::vector<unsigned int> digits1Copy = digits1;
-    std::vector<unsigned int> result(digits1.size() - digits2.size() + 1);
-    unsigned int i = result.size() - 1;
-    while (((digits1Copy.size() > digits2.size()) || ((digits1Copy.size() == digits2.size()) && (digits2[digits2.size() - 1] <= digits1Copy[digits1Copy.size() - 1]))) && (i != static_cast<unsigned int>(-1))) {
-        while (GetVectorCompareResult(GetVectorProduct(digits2, result[i], i), digits1Copy) <= 0)
-            ++result[i];
-        --result[i];
-        digits1Copy = GetVectorDifference(digits1Copy, GetVectorProduct(digits2, result[i], i));
-        --i;
-    }
-    DeleteLeadingZeros(digits1Copy);
-    return digits1Copy;
+// Knuth's Algorithm D. The divisor must be normalized (top bit of its top limb set) and at least two limbs long.
+void BigInteger::DivideVectorsKnuth(const LimbVector& digits1, const LimbVector& digits2, LimbVector& quotient, LimbVector& remainder) {
+    unsigned int size = digits2.size();
+    unsigned long long divisorHigh = digits2[size - 1];
+    unsigned long long divisorNext = digits2[size - 2];
+    remainder = digits1;
+    remainder.push_back(0);
+    quotient.assign(digits1.size() - size + 1, 0);
+    for (unsigned int j = quotient.size() - 1; j != static_cast<unsigned int>(-1); --j) {
+        unsigned long long numerator = (static_cast<unsigned long long>(remainder[j + size]) << baseBits) | remainder[j + size - 1];
+        unsigned long long quotientDigit = numerator / divisorHigh;
+        unsigned long long remainderDigit = numerator % divisorHigh;
+        while (((quotientDigit >> baseBits) != 0) || (quotientDigit * divisorNext > ((remainderDigit << baseBits) | remainder[j + size - 2]))) {
+            --quotientDigit;
+            remainderDigit += divisorHigh;
+            if ((remainderDigit >> baseBits) != 0)
+                break;
+        }
+        unsigned long long carry = 0;
+        long long borrow = 0;
+        for (unsigned int i = 0; i < size; ++i) {
+            carry += quotientDigit * digits2[i];
+            long long difference = static_cast<long long>(remainder[i + j]) - static_cast<long long>(carry & 0xFFFFFFFFULL) - borrow;
+            remainder[i + j] = static_cast<unsigned int>(difference);
+            borrow = (difference < 0 ? 1 : 0);
+            carry >>= baseBits;
+        }
+        long long difference = static_cast<long long>(remainder[j + size]) - static_cast<long long>(carry) - borrow;
+        remainder[j + size] = static_cast<unsigned int>(difference);
+        if (difference < 0) {
+            --quotientDigit;
+            carry = 0;
+            for (unsigned int i = 0; i < size; ++i) {
+                carry += static_cast<unsigned long long>(remainder[i + j]) + digits2[i];
+                remainder[i + j] = static_cast<unsigned int>(carry);
+                carry >>= baseBits;
+            }
+            remainder[j + size] += static_cast<unsigned int>(carry);
+        }
+        quotient[j] = static_cast<unsigned int>(quotientDigit);
+    }
+    remainder.resize(size);
+    DeleteLeadingZeros(quotient);
+    DeleteLeadingZeros(remainder);
+}
+// The dividend is consumed in blocks as long as the normalized divisor d (n limbs). With X = floor(B^2n / d)
+// every block quotient is estimated as floor(r * X / B^n), where r is the running remainder, and is at most 3 too small.
+void BigInteger::DivideVectorsNewton(const LimbVector& digits1, const LimbVector& digits2, const LimbVector& reciprocal, LimbVector& quotient, LimbVector& remainder) {
+    unsigned int size = digits2.size();
+    BigInteger divisor;
+    divisor.digits = digits2;
+    BigInteger rest;
+    quotient.assign(digits1.size(), 0);
+    for (unsigned int i = (digits1.size() - 1) / size; i != static_cast<unsigned int>(-1); --i) {
+        BigInteger current = GetPart(digits1, i * size, (i + 1) * size);
+        PushBackVector(current.digits, rest.digits, size);
+        DeleteLeadingZeros(current.digits);
+        BigInteger blockQuotient = GetPart(GetVectorProduct(rest.digits, reciprocal), size, 3 * size + 1);
+        rest = current - blockQuotient * divisor;
+        while (rest >= divisor) {
+            rest -= divisor;
+            ++blockQuotient;
+        }
+        PushBackVector(quotient, blockQuotient.digits, i * size);
+    }
+    DeleteLeadingZeros(quotient);
+    remainder = rest.digits;
+}
+// floor(B^2n / d) for a normalized n-limb d. The reciprocal of the top n/2 + 2 limbs is refined with one Newton step
+// X' = X + X * (B^2n - d * X) / B^2n, which is then off by a few units at most and is corrected exactly.
+LimbVector BigInteger::GetVectorReciprocal(const LimbVector& digits) {
+    unsigned int size = digits.size();
+    LimbVector power(2 * size + 1, 0);
+    power.back() = 1;
+    unsigned int highSize = size / 2 + 2;
+    if ((size < reciprocalThreshold) || (highSize >= size)) {
+        LimbVector quotient;
+        LimbVector remainder;
+        DivideVectorsKnuth(power, digits, quotient, remainder);
+        return quotient;
+    }
+    BigInteger result;
+    result.digits = GetVectorReciprocal(GetVectorPart(digits, size - highSize, size));
+    result.digits.insert(result.digits.begin(), size - highSize, 0);
+    BigInteger divisor;
+    divisor.digits = digits;
+    BigInteger powerValue;
+    powerValue.digits = power;
+    BigInteger error = powerValue - divisor * result;
+    BigInteger correction = result * error;
+    correction.digits = GetVectorPart(correction.digits, 2 * size, correction.digits.size());
+    if ((correction.digits.size() == 1) && (correction.digits[0] == 0))
+        correction.isNegative = false;
+    result += correction;
+    error = powerValue - divisor * result;
+    while (error < 0) {
+        --result;
+        error += divisor;
+    }
+    while (error >= divisor) {
+        ++result;
+        error -= divisor;
+    }
+    return result.digits;
 }
 BigInteger& BigInteger::operator+=(const BigInteger& bigInt) {
-   if (isNegative == bigInt.isNegative)
-       digits = GetVectorSum(digits, bigInt.digits, false);
-   else {
-       char digitsCompareResult = GetVectorCompareResult(digits, bigInt.digits);
-       switch (digitsCompareResult) {
-           case 1:
-               digits = GetVectorDifference(digits, bigInt.digits);
-               break;
-           case -1:
-               isNegative = !isNegative;
-               digits = GetVectorDifference(bigInt.digits, digits);
-               break;
-           case 0:
-               isNegative = false;
-               digits = {0};
-               break;
-       }
-   }
-   return *this;
+    return AddWithSign(bigInt, bigInt.isNegative);
 }
 BigInteger operator+(const BigInteger& bigInt1, const BigInteger& bigInt2) {
     BigInteger result = bigInt1;
     result += bigInt2;
     return result;
 }
+// The overloads on expiring operands add into the storage of the temporary instead of copying.
+BigInteger operator+(BigInteger&& bigInt1, const BigInteger& bigInt2) {
+    bigInt1 += bigInt2;
+    return std::move(bigInt1);
+}
+BigInteger operator+(const BigInteger& bigInt1, BigInteger&& bigInt2) {
+    bigInt2 += bigInt1;
+    return std::move(bigInt2);
+}
+BigInteger operator+(BigInteger&& bigInt1, BigInteger&& bigInt2) {
+    bigInt1 += bigInt2;
+    return std::move(bigInt1);
+}
 BigInteger& BigInteger::operator-=(const BigInteger& bigInt) {
-    return *this += (-bigInt);
+    return AddWithSign(bigInt, !bigInt.isNegative);
+}
+// Adds bigInt with the given sign in place: the magnitudes are added or subtracted straight into digits.
+BigInteger& BigInteger::AddWithSign(const BigInteger& bigInt, const bool& isBigIntNegative) {
+    if (this == &bigInt) {
+        BigInteger bigIntCopy = bigInt;
+        return AddWithSign(bigIntCopy, isBigIntNegative);
+    }
+    AddLimbsWithSign(bigInt.digits.data(), bigInt.digits.size(), isBigIntNegative);
+    return *this;
+}
+// otherDigits (otherSize limbs without leading zeros) must not overlap digits.
+void BigInteger::AddLimbsWithSign(const unsigned int* otherDigits, const unsigned int& otherSize, const bool& isOtherNegative) {
+    if ((digits.size() == 1) && (otherSize == 1)) {
+        unsigned long long digit = digits[0];
+        unsigned long long otherDigit = otherDigits[0];
+        if (isNegative == isOtherNegative) {
+            digits[0] = static_cast<unsigned int>(digit + otherDigit);
+            if (((digit + otherDigit) >> baseBits) != 0)
+                digits.push_back(1);
+        }
+        else if (digit >= otherDigit) {
+            digits[0] = static_cast<unsigned int>(digit - otherDigit);
+            isNegative = isNegative && (digit != otherDigit);
+        }
+        else {
+            digits[0] = static_cast<unsigned int>(otherDigit - digit);
+            isNegative = !isNegative;
+        }
+        return;
+    }
+    if (isNegative == isOtherNegative) {
+        if (digits.size() < otherSize)
+            digits.resize(otherSize, 0);
+        if (AddLimbs(digits.data(), digits.data(), digits.size(), otherDigits, otherSize) != 0)
+            digits.push_back(1);
+        return;
+    }
+    char compareResult = 0;
+    if (digits.size() != otherSize)
+        compareResult = (digits.size() < otherSize ? -1 : 1);
+    else
+        compareResult = CompareLimbs(digits.data(), otherDigits, otherSize);
+    switch (compareResult) {
+        case 1:
+            SubtractLimbs(digits.data(), digits.data(), digits.size(), otherDigits, otherSize);
+            break;
+        case -1:
+            isNegative = !isNegative;
+            digits.resize(otherSize, 0);
+            SubtractLimbs(digits.data(), otherDigits, otherSize, digits.data(), digits.size());
+            break;
+        case 0:
+            isNegative = false;
+            digits.assign(1, 0);
+            break;
+    }
+    DeleteLeadingZeros(digits);
+}
+// *this += bigInt1 * bigInt2 (or -= when isSubtract). The product lives in the scratch arena, so the only allocation
+// is digits growing, and either factor may be *this.
+BigInteger& BigInteger::AddProduct(const BigInteger& bigInt1, const BigInteger& bigInt2, const bool& isSubtract) {
+    ScratchFrame frame;
+    unsigned int size = bigInt1.digits.size() + bigInt2.digits.size();
+    unsigned int* product = frame.Allocate(size);
+    MultiplyLimbs(product, bigInt1.digits.data(), bigInt1.digits.size(), bigInt2.digits.data(), bigInt2.digits.size());
+    while ((size > 1) && (product[size - 1] == 0))
+        --size;
+    if ((size > 1) || (product[0] != 0))
+        AddLimbsWithSign(product, size, (bigInt1.isNegative != bigInt2.isNegative) != isSubtract);
+    return *this;
+}
+void addmul(BigInteger& result, const BigInteger& bigInt1, const BigInteger& bigInt2) {
+    result.AddProduct(bigInt1, bigInt2, false);
+}
+void submul(BigInteger& result, const BigInteger& bigInt1, const BigInteger& bigInt2) {
+    result.AddProduct(bigInt1, bigInt2, true);
+}
+// result = bigInt1 * bigInt2 + addend, reusing the storage of result; any of the arguments may alias.
+void mul_add_into(BigInteger& result, const BigInteger& bigInt1, const BigInteger& bigInt2, const BigInteger& addend) {
+    if ((&result == &bigInt1) || (&result == &bigInt2)) {
+        if (&result == &addend) {
+            result.AddProduct(bigInt1, bigInt2, false);
+            return;
+        }
+        BigInteger sum = addend;
+        sum.AddProduct(bigInt1, bigInt2, false);
+        result = std::move(sum);
+        return;
+    }
+    result = addend;
+    result.AddProduct(bigInt1, bigInt2, false);
 }
 BigInteger operator-(const BigInteger& bigInt1, const BigInteger& bigInt2) {
     BigInteger result = bigInt1;
     result -= bigInt2;
     return result;
 }
+BigInteger operator-(BigInteger&& bigInt1, const BigInteger& bigInt2) {
+    bigInt1 -= bigInt2;
+    return std::move(bigInt1);
+}
+BigInteger operator-(const BigInteger& bigInt1, BigInteger&& bigInt2) {
+    bigInt2 -= bigInt1;
+    return -std::move(bigInt2);
+}
+BigInteger operator-(BigInteger&& bigInt1, BigInteger&& bigInt2) {
+    bigInt1 -= bigInt2;
+    return std::move(bigInt1);
+}
 BigInteger& BigInteger::operator*=(const BigInteger& bigInt) {
     isNegative = isNegative != bigInt.isNegative;
-    digits = GetVectorProduct(digits, bigInt.digits);
+    if ((digits.size() == 1) && (bigInt.digits.size() == 1)) {
+        unsigned long long product = static_cast<unsigned long long>(digits[0]) * bigInt.digits[0];
+        digits[0] = static_cast<unsigned int>(product);
+        if ((product >> baseBits) != 0)
+            digits.push_back(static_cast<unsigned int>(product >> baseBits));
+    }
+    else
+        digits = GetVectorProduct(digits, bigInt.digits);
     if ((digits[0] == 0) && (digits.size() == 1))
         isNegative = false;
     return *this;
 }
+// Builds the product straight into the result instead of copying bigInt1 first.
 BigInteger operator*(const BigInteger& bigInt1, const BigInteger& bigInt2) {
-    BigInteger result = bigInt1;
-    result *= bigInt2;
+    if ((bigInt1.digits.size() == 1) && (bigInt2.digits.size() == 1)) {
+        BigInteger result = bigInt1;
+        result *= bigInt2;
+        return result;
+    }
+    BigInteger result;
+    result.digits = BigInteger::GetVectorProduct(bigInt1.digits, bigInt2.digits);
+    result.isNegative = (bigInt1.isNegative != bigInt2.isNegative) && result;
     return result;
 }
 BigInteger& BigInteger::operator/=(const BigInteger &bigInt) {
-    isNegative = isNegative != bigInt.isNegative;
-    digits = GetVectorQuotient(digits, bigInt.digits);
-    if ((digits[0] == 0) && (digits.size() == 1))
-        isNegative = false;
+    BigInteger remainder;
+    divmod(*this, bigInt, *this, remainder);
     return *this;
 }
 BigInteger operator/(const BigInteger& bigInt1, const BigInteger& bigInt2) {
@@ -324,10 +970,8 @@ BigInteger operator/(const BigInteger& bigInt1, const BigInteger& bigInt2) {
     return result;
 }
 BigInteger& BigInteger::operator%=(const BigInteger& bigInt) {
-    isNegative = isNegative != bigInt.isNegative;
-    digits = GetVectorRemainder(digits, bigInt.digits);
-    if ((digits[0] == 0) && (digits.size() == 1))
-        isNegative = false;
+    BigInteger quotient;
+    divmod(*this, bigInt, quotient, *this);
     return *this;
 }
 BigInteger operator%(const BigInteger& bigInt1, const BigInteger& bigInt2) {
@@ -335,14 +979,434 @@ BigInteger operator%(const BigInteger& bigInt1, const BigInteger& bigInt2) {
     result %= bigInt2;
     return result;
 }
-BigInteger BigInteger::operator-() const {
+// Truncating division: the quotient is rounded toward zero and the remainder takes the sign of the dividend.
+void divmod(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient, BigInteger& remainder) {
+    LimbVector quotientDigits;
+    LimbVector remainderDigits;
+    BigInteger::DivideVectors(dividend.digits, divisor.digits, quotientDigits, remainderDigits);
+    bool isQuotientNegative = dividend.isNegative != divisor.isNegative;
+    bool isRemainderNegative = dividend.isNegative;
+    quotient.digits.swap(quotientDigits);
+    quotient.isNegative = isQuotientNegative && ((quotient.digits.size() > 1) || (quotient.digits[0] != 0));
+    remainder.digits.swap(remainderDigits);
+    remainder.isNegative = isRemainderNegative && ((remainder.digits.size() > 1) || (remainder.digits[0] != 0));
+}
+BigInteger::Modulus::Modulus(const BigInteger& modulus) : value(modulus), size(modulus.digits.size()), isMontgomery((modulus.digits[0] & 1) != 0) {
+    if (modulus.isNegative || !modulus)
+        throw std::runtime_error("Modulus must be positive.");
+    LimbVector power(2 * size + 1, 0);
+    power.back() = 1;
+    LimbVector quotient;
+    LimbVector remainder;
+    DivideVectors(power, value.digits, quotient, remainder);
+    reciprocal.swap(quotient);
+    if (!isMontgomery)
+        return;
+    montgomerySquare = remainder;
+    montgomerySquare.resize(size);
+    // Newton (Hensel) iteration x' = x * (2 - m * x) doubles the number of correct low bits of m^-1.
+    unsigned int limbInverse = value.digits[0];
+    for (unsigned int i = 0; i < 4; ++i)
+        limbInverse *= 2 - value.digits[0] * limbInverse;
+    inverse = ~limbInverse + 1;
+    BigInteger result;
+    result.digits[0] = limbInverse;
+    for (unsigned int precision = 1; precision < size;) {
+        precision = std::min(2 * precision, size);
+        BigInteger error = GetPart(GetVectorProduct(GetVectorPart(value.digits, 0, precision), result.digits), 0, precision);
+        BigInteger correction;
+        correction.digits.assign(precision + 1, 0);
+        correction.digits.back() = 1;
+        correction += 2;
+        correction -= error;
+        result = GetPart(GetVectorProduct(result.digits, correction.digits), 0, precision);
+    }
+    fullInverse.assign(size, 0);
+    SubtractLimbs(fullInverse.data(), fullInverse.data(), size, result.digits.data(), std::min<unsigned int>(size, result.digits.size()));
+}
+const BigInteger& BigInteger::Modulus::GetValue() const {
+    return value;
+}
+BigInteger BigInteger::Modulus::Reduce(const BigInteger& bigInt) const {
+    if (!bigInt.isNegative && (bigInt < value))
+        return bigInt;
+    BigInteger result = bigInt % value;
+    if (result.isNegative)
+        result += value;
+    return result;
+}
+// result (n limbs, may alias the operands) = a * b * B^-n mod m in Montgomery form, a * b mod m otherwise.
+void BigInteger::Modulus::MultiplyResidues(unsigned int* result, const unsigned int* digits1, const unsigned int* digits2) const {
+    ScratchFrame frame;
+    unsigned int* product = frame.Allocate(2 * size + 1);
+    MultiplyLimbs(product, digits1, size, digits2, size);
+    product[2 * size] = 0;
+    if (isMontgomery)
+        ReduceMontgomery(result, product);
+    else
+        ReduceBarrett(result, product);
+}
+// result (n limbs) = T * B^-n mod m for T < m * B^n, held in 2n + 1 limbs that are overwritten.
+void BigInteger::Modulus::ReduceMontgomery(unsigned int* result, unsigned int* product) const {
+    const unsigned int* modulus = value.digits.data();
+    if (size < montgomeryThreshold) {
+        // Word-by-word REDC: clear the low limb with a multiple of m, n times.
+        for (unsigned int i = 0; i < size; ++i) {
+            unsigned long long factor = static_cast<unsigned int>(product[i] * inverse);
+            unsigned long long carry = 0;
+            for (unsigned int j = 0; j < size; ++j) {
+                carry += factor * modulus[j] + product[i + j];
+                product[i + j] = static_cast<unsigned int>(carry);
+                carry >>= baseBits;
+            }
+            for (unsigned int j = i + size; carry != 0; ++j) {
+                carry += product[j];
+                product[j] = static_cast<unsigned int>(carry);
+                carry >>= baseBits;
+            }
+        }
+    }
+    else {
+        // REDC with whole products: u = (T mod B^n) * (-m^-1) mod B^n, then (T + u * m) / B^n.
+        ScratchFrame frame;
+        unsigned int* factor = frame.Allocate(2 * size);
+        unsigned int* multiple = frame.Allocate(2 * size);
+        MultiplyLimbs(factor, product, size, fullInverse.data(), size);
+        MultiplyLimbs(multiple, factor, size, modulus, size);
+        AddLimbs(product, product, 2 * size + 1, multiple, 2 * size);
+    }
+    unsigned int* rest = product + size;
+    while ((rest[size] != 0) || (CompareLimbs(rest, modulus, size) >= 0))
+        rest[size] -= SubtractLimbs(rest, rest, size, modulus, size);
+    std::copy(rest, rest + size, result);
+}
+// result (n limbs) = T mod m for T < B^2n, held in 2n + 1 limbs that are overwritten. Only the top n + 1 limbs of T
+// enter the quotient estimate floor(floor(T / B^(n-1)) * X / B^(n+1)), which is at most 2 below the true quotient.
+void BigInteger::Modulus::ReduceBarrett(unsigned int* result, unsigned int* product) const {
+    ScratchFrame frame;
+    const unsigned int* modulus = value.digits.data();
+    unsigned int reciprocalSize = reciprocal.size();
+    unsigned int* quotient = frame.Allocate(size + 1 + reciprocalSize);
+    unsigned int* multiple = frame.Allocate(reciprocalSize + size);
+    MultiplyLimbs(quotient, product + size - 1, size + 1, reciprocal.data(), reciprocalSize);
+    MultiplyLimbs(multiple, quotient + size + 1, reciprocalSize, modulus, size);
+    SubtractLimbs(product, product, size + 1, multiple, size + 1);
+    while ((product[size] != 0) || (CompareLimbs(product, modulus, size) >= 0))
+        product[size] -= SubtractLimbs(product, product, size, modulus, size);
+    std::copy(product, product + size, result);
+}
+LimbVector BigInteger::Modulus::ToResidue(const BigInteger& bigInt) const {
+    LimbVector residue = Reduce(bigInt).digits;
+    residue.resize(size);
+    if (isMontgomery)
+        MultiplyResidues(residue.data(), residue.data(), montgomerySquare.data());
+    return residue;
+}
+BigInteger BigInteger::Modulus::FromResidue(const LimbVector& residue) const {
+    BigInteger result;
+    result.digits = residue;
+    if (isMontgomery) {
+        ScratchFrame frame;
+        unsigned int* product = frame.Allocate(2 * size + 1);
+        std::copy(residue.begin(), residue.end(), product);
+        std::fill(product + size, product + 2 * size + 1, 0);
+        ReduceMontgomery(result.digits.data(), product);
+    }
+    DeleteLeadingZeros(result.digits);
+    return result;
+}
+BigInteger BigInteger::Modulus::Multiply(const BigInteger& bigInt1, const BigInteger& bigInt2) const {
+    LimbVector residue1 = Reduce(bigInt1).digits;
+    LimbVector residue2 = Reduce(bigInt2).digits;
+    residue1.resize(size);
+    residue2.resize(size);
+    ScratchFrame frame;
+    unsigned int* product = frame.Allocate(2 * size + 1);
+    MultiplyLimbs(product, residue1.data(), size, residue2.data(), size);
+    product[2 * size] = 0;
+    BigInteger result;
+    result.digits.swap(residue1);
+    ReduceBarrett(result.digits.data(), product);
+    DeleteLeadingZeros(result.digits);
+    return result;
+}
+// Left-to-right sliding-window exponentiation over the odd powers base^1, base^3, ..., base^(2^w - 1).
+BigInteger BigInteger::Modulus::Power(const BigInteger& base, const BigInteger& exponent) const {
+    static const unsigned int windowThresholds[] = {8, 24, 80, 240, 672};
+    if (exponent.isNegative)
+        return Power(modinv(base, value), -exponent);
+    if (!exponent)
+        return Reduce(1);
+    unsigned int bitCount = exponent.digits.size() * baseBits - GetLeadingZeroCount(exponent.digits.back());
+    unsigned int windowSize = 1;
+    while ((windowSize < 6) && (bitCount > windowThresholds[windowSize - 1]))
+        ++windowSize;
+    auto getBit = [&exponent](const unsigned int& index) {
+        return (exponent.digits[index / baseBits] >> (index % baseBits)) & 1;
+    };
+    std::vector<LimbVector> oddPowers(1, ToResidue(base));
+    LimbVector square(size);
+    MultiplyResidues(square.data(), oddPowers[0].data(), oddPowers[0].data());
+    for (unsigned int i = 1; i < (1U << (windowSize - 1)); ++i) {
+        oddPowers.emplace_back(size);
+        MultiplyResidues(oddPowers[i].data(), oddPowers[i - 1].data(), square.data());
+    }
+    LimbVector result;
+    for (unsigned int i = bitCount - 1; i != static_cast<unsigned int>(-1);) {
+        if (getBit(i) == 0) {
+            MultiplyResidues(result.data(), result.data(), result.data());
+            --i;
+            continue;
+        }
+        unsigned int low = (i + 1 >= windowSize ? i + 1 - windowSize : 0);
+        while (getBit(low) == 0)
+            ++low;
+        unsigned int window = 0;
+        for (unsigned int j = i; j != low - 1; --j)
+            window = 2 * window + getBit(j);
+        if (result.empty())
+            result = oddPowers[window / 2];
+        else {
+            for (unsigned int j = low; j <= i; ++j)
+                MultiplyResidues(result.data(), result.data(), result.data());
+            MultiplyResidues(result.data(), result.data(), oddPowers[window / 2].data());
+        }
+        i = low - 1;
+    }
+    return FromResidue(result);
+}
+// a * b mod m in [0, m). A single product does not repay building a Modulus, so this reduces by plain division.
+BigInteger mulmod(const BigInteger& bigInt1, const BigInteger& bigInt2, const BigInteger& modulus) {
+    if (modulus.isNegative || !modulus)
+        throw std::runtime_error("Modulus must be positive.");
+    BigInteger result = bigInt1 * bigInt2 % modulus;
+    if (result.isNegative)
+        result += modulus;
+    return result;
+}
+BigInteger mulmod(const BigInteger& bigInt1, const BigInteger& bigInt2, const BigInteger::Modulus& modulus) {
+    return modulus.Multiply(bigInt1, bigInt2);
+}
+BigInteger powmod(const BigInteger& base, const BigInteger& exponent, const BigInteger& modulus) {
+    return BigInteger::Modulus(modulus).Power(base, exponent);
+}
+BigInteger powmod(const BigInteger& base, const BigInteger& exponent, const BigInteger::Modulus& modulus) {
+    return modulus.Power(base, exponent);
+}
+// Lehmer's algorithm (HAC 14.57). A single-precision Euclid on the leading 32 bits of x and y runs as long as its
+// quotients provably match the true ones; the collected cosequence (A, B, C, D) then replaces x and y in one linear
+// pass. When cofactor is given it tracks u with u * x0 = x (mod y0) for the original x0 and y0.
+LimbVector BigInteger::GetVectorGcd(LimbVector x, LimbVector y, BigInteger* cofactor) {
+    BigInteger nextCofactor;
+    if (cofactor != nullptr)
+        *cofactor = 1;
+    if (GetVectorCompareResult(x, y) < 0) {
+        x.swap(y);
+        if (cofactor != nullptr)
+            std::swap(*cofactor, nextCofactor);
+    }
+    // Both kinds of step keep x >= y.
+    while ((y.size() > 1) || (y[0] != 0)) {
+        if ((cofactor == nullptr) && (x.size() <= 2)) {
+            unsigned long long value1 = (static_cast<unsigned long long>(x.size() > 1 ? x[1] : 0) << baseBits) | x[0];
+            unsigned long long value2 = (static_cast<unsigned long long>(y.size() > 1 ? y[1] : 0) << baseBits) | y[0];
+            while (value2 != 0) {
+                value1 %= value2;
+                std::swap(value1, value2);
+            }
+            return GetFromWord(value1).digits;
+        }
+        unsigned int shift = GetBitLength(x);
+        shift = (shift > baseBits ? shift - baseBits : 0);
+        LimbVector xPart = GetVectorPart(x, shift / baseBits, shift / baseBits + 2);
+        LimbVector yPart = GetVectorPart(y, shift / baseBits, shift / baseBits + 2);
+        ShiftRight(xPart, shift % baseBits);
+        ShiftRight(yPart, shift % baseBits);
+        long long xHigh = xPart[0];
+        long long yHigh = yPart[0];
+        long long a = 1, b = 0, c = 0, d = 1;
+        while ((yHigh + c > 0) && (yHigh + d > 0) && (xHigh + a >= 0) && (xHigh + b >= 0)) {
+            long long quotient = (xHigh + a) / (yHigh + c);
+            if (quotient != (xHigh + b) / (yHigh + d))
+                break;
+            long long next = a - quotient * c;
+            a = c;
+            c = next;
+            next = b - quotient * d;
+            b = d;
+            d = next;
+            next = xHigh - quotient * yHigh;
+            xHigh = yHigh;
+            yHigh = next;
+        }
+        if (b == 0) {
+            LimbVector quotient;
+            LimbVector remainder;
+            DivideVectors(x, y, quotient, remainder);
+            x.swap(y);
+            y.swap(remainder);
+            if (cofactor != nullptr) {
+                BigInteger quotientValue;
+                quotientValue.digits.swap(quotient);
+                *cofactor -= quotientValue * nextCofactor;
+                std::swap(*cofactor, nextCofactor);
+            }
+        }
+        else {
+            CombineVectors(x, y, a, b, c, d);
+            if (cofactor != nullptr) {
+                BigInteger newCofactor = GetScaled(*cofactor, a) + GetScaled(nextCofactor, b);
+                nextCofactor = GetScaled(*cofactor, c) + GetScaled(nextCofactor, d);
+                *cofactor = std::move(newCofactor);
+            }
+        }
+    }
+    return x;
+}
+// (x, y) = (a * x + b * y, c * x + d * y) for coefficients below 2^32 in magnitude whose results are non-negative.
+void BigInteger::CombineVectors(LimbVector& x, LimbVector& y, const long long& a, const long long& b, const long long& c, const long long& d) {
+    unsigned int size = x.size();
+    y.resize(size);
+    __int128 carry1 = 0;
+    __int128 carry2 = 0;
+    for (unsigned int i = 0; i < size; ++i) {
+        carry1 += static_cast<__int128>(a) * x[i] + static_cast<__int128>(b) * y[i];
+        carry2 += static_cast<__int128>(c) * x[i] + static_cast<__int128>(d) * y[i];
+        x[i] = static_cast<unsigned int>(carry1);
+        y[i] = static_cast<unsigned int>(carry2);
+        carry1 >>= baseBits;
+        carry2 >>= baseBits;
+    }
+    DeleteLeadingZeros(x);
+    DeleteLeadingZeros(y);
+}
+BigInteger BigInteger::GetScaled(const BigInteger& bigInt, const long long& factor) {
+    BigInteger result = bigInt;
+    MultiplyAddVector(result.digits, static_cast<unsigned int>(factor < 0 ? -factor : factor), 0);
+    DeleteLeadingZeros(result.digits);
+    result.isNegative = (bigInt.isNegative != (factor < 0)) && result;
+    return result;
+}
+BigInteger BigInteger::GetFromWord(const unsigned long long& value) {
+    BigInteger result;
+    result.digits[0] = static_cast<unsigned int>(value);
+    if ((value >> baseBits) != 0)
+        result.digits.push_back(static_cast<unsigned int>(value >> baseBits));
+    return result;
+}
+unsigned int BigInteger::GetBitLength(const LimbVector& digits) {
+    if (digits.back() == 0)
+        return 0;
+    return digits.size() * baseBits - GetLeadingZeroCount(digits.back());
+}
+void BigInteger::ShiftLeftBits(LimbVector& digits, const unsigned int& shift) {
+    digits.insert(digits.begin(), shift / baseBits, 0);
+    ShiftLeft(digits, shift % baseBits);
+    DeleteLeadingZeros(digits);
+}
+void BigInteger::ShiftRightBits(LimbVector& digits, const unsigned int& shift) {
+    digits = GetVectorPart(digits, shift / baseBits, digits.size());
+    ShiftRight(digits, shift % baseBits);
+}
+BigInteger BigInteger::GetPower(BigInteger base, unsigned int exponent) {
+    BigInteger result = 1;
+    for (; exponent != 0; exponent >>= 1) {
+        if (exponent & 1)
+            result *= base;
+        if (exponent > 1)
+            base *= base;
+    }
+    return result;
+}
+// floor(n^(1/k)) for n >= 0. The root of n / 2^(k * s) gives the top half of the bits of the result, and Newton's
+// iteration x' = ((k - 1) * x + n / x^(k - 1)) / k, which never drops below the root, finishes it in a step or two.
+// Small roots start from a floating-point estimate instead.
+BigInteger BigInteger::GetRoot(const BigInteger& bigInt, const unsigned int& k) {
+    unsigned int bitLength = GetBitLength(bigInt.digits);
+    if ((k == 1) || (bitLength <= 1))
+        return bigInt;
+    BigInteger result;
+    if (bitLength / k < baseBits) {
+        LimbVector top = bigInt.digits;
+        unsigned int shift = (bitLength > 64 ? bitLength - 64 : 0);
+        ShiftRightBits(top, shift);
+        double value = static_cast<double>(top[0]) + (top.size() > 1 ? std::ldexp(static_cast<double>(top[1]), baseBits) : 0.0);
+        double root = std::exp2((std::log2(value) + shift) / k);
+        result = GetFromWord(static_cast<unsigned long long>(root * (1 + 1e-9)) + 2);
+    }
+    else {
+        unsigned int shift = bitLength / (2 * k);
+        BigInteger high = bigInt;
+        ShiftRightBits(high.digits, k * shift);
+        result = GetRoot(high, k);
+        ShiftLeftBits(result.digits, shift);
+        // result is at most the root, so one step lands at or above it.
+        result = (result * (k - 1) + bigInt / GetPower(result, k - 1)) / k;
+    }
+    while (true) {
+        BigInteger next = (result * (k - 1) + bigInt / GetPower(result, k - 1)) / k;
+        if (next >= result)
+            return result;
+        result = std::move(next);
+    }
+}
+BigInteger gcd(const BigInteger& bigInt1, const BigInteger& bigInt2) {
+    BigInteger result;
+    result.digits = BigInteger::GetVectorGcd(bigInt1.digits, bigInt2.digits, nullptr);
+    return result;
+}
+// Returns g = gcd(a, b) >= 0 and sets x, y with a * x + b * y = g.
+BigInteger gcdext(const BigInteger& bigInt1, const BigInteger& bigInt2, BigInteger& x, BigInteger& y) {
+    BigInteger result;
+    BigInteger cofactor;
+    result.digits = BigInteger::GetVectorGcd(bigInt1.digits, bigInt2.digits, &cofactor);
+    if (bigInt1.isNegative)
+        cofactor = -cofactor;
+    BigInteger otherCofactor = (bigInt2 ? (result - bigInt1 * cofactor) / bigInt2 : BigInteger());
+    x = std::move(cofactor);
+    y = std::move(otherCofactor);
+    return result;
+}
+BigInteger modinv(const BigInteger& bigInt, const BigInteger& modulus) {
+    if (modulus.isNegative || !modulus)
+        throw std::runtime_error("Modulus must be positive.");
+    BigInteger x;
+    BigInteger y;
+    if (gcdext(bigInt, modulus, x, y) != 1)
+        throw std::runtime_error("Inverse does not exist.");
+    x %= modulus;
+    if (x.isNegative)
+        x += modulus;
+    return x;
+}
+BigInteger isqrt(const BigInteger& bigInt) {
+    if (bigInt.isNegative)
+        throw std::runtime_error("Square root of a negative number.");
+    return BigInteger::GetRoot(bigInt, 2);
+}
+// Rounds toward zero; odd roots of negative numbers are negative.
+BigInteger iroot(const BigInteger& bigInt, const unsigned int& k) {
+    if (k == 0)
+        throw std::runtime_error("Zeroth root.");
+    if (bigInt.isNegative && (k % 2 == 0))
+        throw std::runtime_error("Even root of a negative number.");
+    if (bigInt.isNegative)
+        return -BigInteger::GetRoot(-bigInt, k);
+    return BigInteger::GetRoot(bigInt, k);
+}
+BigInteger BigInteger::operator-() const& {
     BigInteger result = *this;
-    if (result != BigInteger())
+    if (result)
         result.isNegative = !result.isNegative;
     return result;
 }
+BigInteger BigInteger::operator-() && {
+    if (*this)
+        isNegative = !isNegative;
+    return std::move(*this);
+}
 BigInteger& BigInteger::operator++() {
-    return *this = *this + 1;
+    return AddUnit(false);
 }
 BigInteger BigInteger::operator++(int) {
     BigInteger bigIntCopy = *this;
@@ -350,7 +1414,32 @@ BigInteger BigInteger::operator++(int) {
     return bigIntCopy;
 }
 BigInteger& BigInteger::operator--() {
-    return *this = *this - 1;
+    return AddUnit(true);
+}
+// Adds +1 or -1 in place: the magnitude grows or shrinks by one, with the carry or borrow rippling only as far as needed.
+BigInteger& BigInteger::AddUnit(const bool& isUnitNegative) {
+    if ((digits.size() == 1) && (digits[0] == 0)) {
+        digits[0] = 1;
+        isNegative = isUnitNegative;
+    }
+    else if (isNegative == isUnitNegative) {
+        unsigned int i = 0;
+        for (; (i < digits.size()) && (digits[i] == 0xFFFFFFFFU); ++i)
+            digits[i] = 0;
+        if (i == digits.size())
+            digits.push_back(1);
+        else
+            ++digits[i];
+    }
+    else {
+        unsigned int i = 0;
+        for (; digits[i] == 0; ++i)
+            digits[i] = 0xFFFFFFFFU;
+        --digits[i];
+        DeleteLeadingZeros(digits);
+        isNegative = isNegative && ((digits.size() > 1) || (digits[0] != 0));
+    }
+    return *this;
 }
 BigInteger BigInteger::operator--(int) {
     BigInteger bigIntCopy = *this;
@@ -358,36 +1447,214 @@ BigInteger BigInteger::operator--(int) {
     return bigIntCopy;
 }
 std::string BigInteger::toString() const {
-    std::string bigIntString = "";
-    if (isNegative)
-        bigIntString += "-";
-    for (auto it = digits.rbegin(); it != digits.rend(); ++it)
-        bigIntString += std::to_string(*it);
+    unsigned int groupCount = 1;
+    while (groupCount * decimalBaseLength < digits.size() * 10)
+        groupCount *= 2;
+    std::vector<unsigned int> groups;
+    groups.reserve(groupCount);
+    AppendDecimalGroups(digits, groupCount, groups);
+    while ((groups.size() > 1) && (groups.back() == 0))
+        groups.pop_back();
+    std::string bigIntString = (isNegative ? "-" : "") + std::to_string(groups.back());
+    unsigned int position = bigIntString.size();
+    bigIntString.resize(position + (groups.size() - 1) * decimalBaseLength);
+    for (auto it = groups.rbegin() + 1; it != groups.rend(); ++it, position += decimalBaseLength) {
+        unsigned int group = *it;
+        for (unsigned int j = decimalBaseLength - 1; j != static_cast<unsigned int>(-1); --j, group /= 10)
+            bigIntString[position + j] = static_cast<char>('0' + group % 10);
+    }
     return bigIntString;
 }
+// Single-limb values, the common case for many small numbers, are formatted without building a string.
 std::ostream& operator<<(std::ostream& os, const BigInteger& bigInt) {
+    if (bigInt.digits.size() == 1)
+        return os << (bigInt.isNegative ? "-" : "") << bigInt.digits[0];
     os << bigInt.toString();
     return os;
 }
+OutputWriter& operator<<(OutputWriter& writer, const BigInteger& bigInt) {
+    if (bigInt.isNegative)
+        writer << '-';
+    if (bigInt.digits.size() == 1)
+        writer << bigInt.digits[0];
+    else {
+        std::string bigIntString = bigInt.toString();
+        writer.Write(bigIntString.data() + bigInt.isNegative, bigIntString.size() - bigInt.isNegative);
+    }
+    return writer;
+}
+// Reads the number straight from a character source with Peek() and Next() (the current character and the one after
+// it, negative at the end): digits are packed into base 10^9 groups as they arrive, so the token is never copied into
+// a string. False if there are no digits.
+template<typename Source>
+bool BigInteger::ReadDecimal(Source& source, BigInteger& bigInt) {
+    int c = source.Peek();
+    bool isNegative = false;
+    if ((c == '-') || (c == '+')) {
+        isNegative = c == '-';
+        c = source.Next();
+    }
+    bool hasDigits = false;
+    for (; c == '0'; c = source.Next())
+        hasDigits = true;
+    std::vector<unsigned int> groups;
+    unsigned int group = 0;
+    unsigned int groupLength = 0;
+    unsigned int groupBase = 1;
+    for (; (c >= '0') && (c <= '9'); c = source.Next()) {
+        hasDigits = true;
+        if (groupLength == decimalBaseLength) {
+            groups.push_back(group);
+            group = 0;
+            groupLength = 0;
+            groupBase = 1;
+        }
+        group = group * 10 + (c - '0');
+        groupBase *= 10;
+        ++groupLength;
+    }
+    if (!hasDigits)
+        return false;
+    std::reverse(groups.begin(), groups.end());
+    bigInt.digits = GetVectorFromDecimalGroups(groups, 0, groups.size());
+    MultiplyAddVector(bigInt.digits, groupBase, group);
+    DeleteLeadingZeros(bigInt.digits);
+    bigInt.isNegative = isNegative && ((bigInt.digits.size() > 1) || (bigInt.digits[0] != 0));
+    return true;
+}
 std::istream& operator>>(std::istream& is, BigInteger& bigInt) {
-    std::string num = "";
-    is >> num;
-    bigInt = BigInteger(num);
+    std::istream::sentry sentry(is);
+    if (!sentry)
+        return is;
+    struct StreamSource {
+        std::streambuf* buffer;
+        bool isAtEnd;
+        explicit StreamSource(std::streambuf* buffer) : buffer(buffer), isAtEnd(false) {}
+        int Peek() {
+            return Check(buffer->sgetc());
+        }
+        int Next() {
+            return Check(buffer->snextc());
+        }
+        int Check(const std::istream::int_type& c) {
+            isAtEnd = c == std::istream::traits_type::eof();
+            return (isAtEnd ? -1 : c);
+        }
+    } source(is.rdbuf());
+    bool isRead = BigInteger::ReadDecimal(source, bigInt);
+    if (source.isAtEnd)
+        is.setstate(std::ios_base::eofbit);
+    if (!isRead)
+        is.setstate(std::ios_base::failbit);
     return is;
 }
-void BigInteger::Add(std::vector<unsigned int>& v, const unsigned int& index, const unsigned int& value) {
-    unsigned int size = v.size();
-    for (unsigned int i = 0; i + size <= index; ++i)
-        v.push_back(0);
-    v[index] += value;
+InputReader& operator>>(InputReader& reader, BigInteger& bigInt) {
+    if (reader && (!reader.SkipSpace() || !BigInteger::ReadDecimal(reader, bigInt)))
+        reader.SetFailed();
+    return reader;
+}
+void BigInteger::PushBackVector(LimbVector& to, const LimbVector& from, const unsigned int& index) {
+    if (to.size() < index + from.size())
+        to.resize(index + from.size(), 0);
+    if (AddLimbs(to.data() + index, to.data() + index, to.size() - index, from.data(), from.size()) != 0)
+        to.push_back(1);
+}
+unsigned int BigInteger::DivideVector(LimbVector& digits, const unsigned int& divisor) {
+    unsigned int remainder = DivideLimbs(digits.data(), digits.size(), divisor);
+    DeleteLeadingZeros(digits);
+    return remainder;
+}
+void BigInteger::MultiplyAddVector(LimbVector& digits, const unsigned int& multiplier, const unsigned int& addend) {
+    unsigned long long carry = addend;
+    for (unsigned int& digit : digits) {
+        carry += static_cast<unsigned long long>(digit) * multiplier;
+        digit = static_cast<unsigned int>(carry);
+        carry >>= baseBits;
+    }
+    if (carry != 0)
+        digits.push_back(static_cast<unsigned int>(carry));
+}
+void BigInteger::ShiftLeft(LimbVector& digits, const unsigned int& shift) {
+    if (shift == 0)
+        return;
+    digits.push_back(0);
+    for (unsigned int i = digits.size() - 1; i != 0; --i)
+        digits[i] = (digits[i] << shift) | (digits[i - 1] >> (baseBits - shift));
+    digits[0] <<= shift;
+    DeleteLeadingZeros(digits);
 }
-void BigInteger::PushBackVector(std::vector<unsigned int>& to, const std::vector<unsigned int>& from, const unsigned int& index) {
-    for (unsigned int i = 0; i < from.size(); ++i)
-        Add(to, i + index, from[i]);
+void BigInteger::ShiftRight(LimbVector& digits, const unsigned int& shift) {
+    if (shift == 0)
+        return;
+    for (unsigned int i = 0; i + 1 < digits.size(); ++i)
+        digits[i] = (digits[i] >> shift) | (digits[i + 1] << (baseBits - shift));
+    digits.back() >>= shift;
+    DeleteLeadingZeros(digits);
 }
-unsigned int BigInteger::GetTwoPower(const unsigned int& x) {
-    unsigned int n = 1;
-    while (x > n)
-        n *= 2;
-    return n;
+unsigned int BigInteger::GetLeadingZeroCount(unsigned int digit) {
+    unsigned int count = 0;
+    for (; (digit & 0x80000000U) == 0; digit <<= 1)
+        ++count;
+    return count;
 }
+// (10^9)^(2^k), computed on first use by repeated squaring and cached per thread.
+const LimbVector& BigInteger::GetDecimalPower(const unsigned int& k) {
+    static thread_local std::vector<LimbVector> decimalPowers(1, LimbVector(1, decimalBase));
+    while (decimalPowers.size() <= k)
+        decimalPowers.push_back(GetVectorProduct(decimalPowers.back(), decimalPowers.back()));
+    return decimalPowers[k];
+}
+const LimbVector& BigInteger::GetDecimalPowerReciprocal(const unsigned int& k) {
+    static thread_local std::vector<LimbVector> reciprocals;
+    if (reciprocals.size() <= k)
+        reciprocals.resize(k + 1);
+    if (reciprocals[k].empty()) {
+        LimbVector power = GetDecimalPower(k);
+        ShiftLeft(power, GetLeadingZeroCount(power.back()));
+        reciprocals[k] = GetVectorReciprocal(power);
+    }
+    return reciprocals[k];
+}
+// Value of the base 10^9 groups [from, to) (least significant first), split at a power of two so that
+// high * (10^9)^(2^k) + low only needs cached powers.
+LimbVector BigInteger::GetVectorFromDecimalGroups(const std::vector<unsigned int>& groups, const unsigned int& from, const unsigned int& to) {
+    if (to - from <= decimalConversionThreshold) {
+        LimbVector result(1, 0);
+        for (unsigned int i = to - 1; i != from - 1; --i)
+            MultiplyAddVector(result, decimalBase, groups[i]);
+        return result;
+    }
+    unsigned int k = 0;
+    while ((2U << k) < to - from)
+        ++k;
+    LimbVector result = GetVectorProduct(GetVectorFromDecimalGroups(groups, from + (1U << k), to), GetDecimalPower(k));
+    PushBackVector(result, GetVectorFromDecimalGroups(groups, from, from + (1U << k)), 0);
+    DeleteLeadingZeros(result);
+    return result;
+}
+// Appends exactly groupCount (a power of two) base 10^9 groups of digits, least significant first.
+void BigInteger::AppendDecimalGroups(const LimbVector& digits, const unsigned int& groupCount, std::vector<unsigned int>& groups) {
+    if ((digits.size() == 1) && (digits[0] == 0)) {
+        groups.resize(groups.size() + groupCount, 0);
+        return;
+    }
+    if ((groupCount <= decimalConversionThreshold) || (digits.size() <= decimalConversionThreshold)) {
+        LimbVector digitsCopy = digits;
+        for (unsigned int i = 0; i < groupCount; ++i)
+            groups.push_back(DivideVector(digitsCopy, decimalBase));
+        return;
+    }
+    unsigned int k = 0;
+    while ((2U << k) < groupCount)
+        ++k;
+    LimbVector quotient;
+    LimbVector remainder;
+    if (GetDecimalPower(k).size() < newtonThreshold)
+        DivideVectors(digits, GetDecimalPower(k), quotient, remainder);
+    else
+        DivideVectors(digits, GetDecimalPower(k), quotient, remainder, &GetDecimalPowerReciprocal(k));
+    AppendDecimalGroups(remainder, groupCount / 2, groups);
+    AppendDecimalGroups(quotient, groupCount / 2, groups);
+}
+
+#endif
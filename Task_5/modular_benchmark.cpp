@@ -0,0 +1,98 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "biginteger.h"
+
+// Modular arithmetic through BigInteger::Modulus against the plain operators it replaces, on random operands of every
+// listed number of decimal digits, once with an odd modulus (Montgomery powers) and once with an even one (Barrett
+// only). Repeated products x = x * b mod m are timed through (x * b) % m and through mulmod with a prepared Modulus;
+// powers b^e mod m through a right-to-left square-and-multiply loop over (x * y) % m and through powmod, with an
+// exponent of a third as many digits as the modulus. Both paths must agree, or the run fails.
+
+// Random positive number of exactly digitCount decimal digits.
+BigInteger GetRandomNumber(const unsigned int& digitCount, std::mt19937& generator) {
+    std::string digits(digitCount, '0');
+    for (char& digit : digits)
+        digit = static_cast<char>('0' + generator() % 10);
+    digits[0] = static_cast<char>('1' + generator() % 9);
+    return BigInteger(digits);
+}
+
+double Measure(const std::function<void()>& run) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    run();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int32_t main(int32_t argc, char** argv) {
+    try {
+        std::vector<unsigned int> digitCounts;
+        for (int32_t i = 1; i < argc; ++i) {
+            int digitCount = std::stoi(argv[i]);
+            if (digitCount < 3) {
+                std::cerr << "Usage: " << argv[0] << " [digits...]" << std::endl;
+                return 1;
+            }
+            digitCounts.push_back(digitCount);
+        }
+        if (digitCounts.empty())
+            digitCounts = {100, 300, 1000, 3000};
+        std::cout << "digits  modulus  products    (a*b)%m     mulmod  speedup  exponent bits  square-multiply"
+                  << "     powmod  speedup  check" << std::endl;
+        bool isConsistent = true;
+        for (unsigned int digitCount : digitCounts)
+            for (bool isOdd : {true, false}) {
+                std::mt19937 generator(digitCount);
+                BigInteger modulus = GetRandomNumber(digitCount, generator);
+                if ((modulus % 2 == 1) != isOdd)
+                    ++modulus;
+                BigInteger base = GetRandomNumber(digitCount - 1, generator);
+                BigInteger exponent = GetRandomNumber(digitCount / 3, generator);
+                unsigned int productCount = 300000 / digitCount;
+                BigInteger plainProduct = base;
+                double plainProductTime = Measure([&]() {
+                    for (unsigned int i = 0; i < productCount; ++i)
+                        plainProduct = plainProduct * base % modulus;
+                });
+                BigInteger product = base;
+                double productTime = Measure([&]() {
+                    BigInteger::Modulus context(modulus);
+                    for (unsigned int i = 0; i < productCount; ++i)
+                        product = mulmod(product, base, context);
+                });
+                unsigned int exponentBits = 0;
+                for (BigInteger rest = exponent; rest; rest /= 2)
+                    ++exponentBits;
+                BigInteger plainPower = 1;
+                double plainPowerTime = Measure([&]() {
+                    BigInteger square = base;
+                    for (BigInteger rest = exponent; rest; rest /= 2) {
+                        if (rest % 2 == 1)
+                            plainPower = plainPower * square % modulus;
+                        square = square * square % modulus;
+                    }
+                });
+                BigInteger power;
+                double powerTime = Measure([&]() { power = powmod(base, exponent, modulus); });
+                bool isMatch = plainProduct == product && plainPower == power;
+                isConsistent = isConsistent && isMatch;
+                std::cout << std::setw(6) << digitCount << std::setw(9) << (isOdd ? "odd" : "even") << std::setw(10)
+                          << productCount << std::fixed << std::setprecision(4) << std::setw(11) << plainProductTime
+                          << std::setw(11) << productTime << std::setprecision(2) << std::setw(8)
+                          << plainProductTime / productTime << "x" << std::setw(15) << exponentBits
+                          << std::setprecision(4) << std::setw(17) << plainPowerTime << std::setw(11) << powerTime
+                          << std::setprecision(2) << std::setw(8) << plainPowerTime / powerTime << "x  "
+                          << (isMatch ? "ok" : "MISMATCH") << std::endl;
+            }
+        return (isConsistent ? 0 : 1);
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+}
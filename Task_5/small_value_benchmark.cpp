@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "biginteger.h"
+
+// BigInteger on values of a machine word or two, where the cost is the bookkeeping around the limbs rather than the
+// arithmetic: a counting loop (++i, sum += i, i < limit), comparisons between small values of both signs, and small
+// products and differences. Only operators that BigInteger has always had are used, so the same source builds against
+// older revisions of biginteger.h for a before-and-after comparison. The checksum of every stage has to be the same
+// there.
+
+struct Measurement {
+    std::string stage;
+    double seconds = 0;
+    std::string checksum;
+};
+
+Measurement Measure(const std::string& stage, const std::function<std::string()>& run) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Measurement measurement;
+    measurement.stage = stage;
+    measurement.checksum = run();
+    measurement.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return measurement;
+}
+
+int32_t main(int32_t argc, char** argv) {
+    int iterationCount = (argc > 1 ? std::stoi(argv[1]) : 3000000);
+    if (argc > 2 || iterationCount <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [iterations]" << std::endl;
+        return 1;
+    }
+    std::vector<Measurement> measurements;
+    measurements.push_back(Measure("counter (++i, sum += i)", [&]() {
+        BigInteger sum = 0;
+        BigInteger limit = iterationCount;
+        for (BigInteger i = 0; i < limit; ++i)
+            sum += i;
+        return sum.toString();
+    }));
+    // 1000 values in [-500, 500) compared all against all, a million pairs per million iterations.
+    measurements.push_back(Measure("compare (<, ==, >=)", [&]() {
+        std::vector<BigInteger> values;
+        for (int i = 0; i < 1000; ++i)
+            values.push_back(BigInteger(i * 7919 % 1000 - 500));
+        long long count = 0;
+        for (int round = 0; round < std::max(1, iterationCount / 1000000); ++round)
+            for (const BigInteger& value1 : values)
+                for (const BigInteger& value2 : values)
+                    count += (value1 < value2) + (value1 == value2) + (value1 >= value2);
+        return std::to_string(count);
+    }));
+    measurements.push_back(Measure("small arithmetic (*, -=)", [&]() {
+        BigInteger product = 1;
+        BigInteger total = 0;
+        for (int i = 0; i < iterationCount; ++i) {
+            product = BigInteger(i % 1000) * BigInteger(i % 77 + 1);
+            product -= 5;
+            total += product;
+        }
+        return total.toString();
+    }));
+    std::cout << "stage                        seconds  checksum" << std::endl;
+    for (const Measurement& measurement : measurements)
+        std::cout << std::left << std::setw(26) << measurement.stage << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(9) << measurement.seconds << "  " << measurement.checksum << std::endl;
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Common/convolution.h"
+#include "filter.h"
+#include "profile.h"
+#include "wav.h"
+
+// Every allocation of the process goes through here, so a stage's allocations are the difference of the counters
+// around one run of it.
+std::atomic<uint64_t> allocationCount(0);
+std::atomic<uint64_t> allocatedSize(0);
+
+void* operator new(size_t size) {
+    ++allocationCount;
+    allocatedSize += size;
+    if (void* pointer = malloc(size == 0 ? 1 : size))
+        return pointer;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+// Not inlined, or the compiler takes the free inside for one that does not match the caller's new.
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+void operator delete[](void* pointer) noexcept {
+    operator delete(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+void operator delete[](void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+// One row of the results: the fastest of the repeated runs of a stage and the allocations of a single run.
+struct StageResult {
+    std::string precision;
+    uint32_t size = 0;
+    std::string stage;
+    double nanosecondsPerSample = 0;
+    uint64_t allocationCount = 0;
+    uint64_t allocatedSize = 0;
+    uint64_t peakResidentSize = 0;
+};
+
+const char* resultsHeader = "precision,size,stage,ns_per_sample,allocations,allocated_bytes,peak_rss_kb";
+
+// Runs stage after setup until it has taken at least minimumTime in total (and at least three times), and returns the
+// fastest run. Setup is not timed; it prepares the state the stage consumes.
+StageResult Measure(const std::string& name, const uint32_t& size, const double& minimumTime,
+                    const std::function<void()>& setup, const std::function<void()>& stage) {
+    StageResult result;
+    result.size = size;
+    result.stage = name;
+    double best = 1e300;
+    double total = 0;
+    for (uint32_t run = 0; run < 3 || total < minimumTime; ++run) {
+        setup();
+        uint64_t allocationsBefore = allocationCount;
+        uint64_t sizeBefore = allocatedSize;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        stage();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // The first run warms caches and free lists up, the allocations of a later one are the steady state.
+        if (run == 1) {
+            result.allocationCount = allocationCount - allocationsBefore;
+            result.allocatedSize = allocatedSize - sizeBefore;
+        }
+        best = std::min(best, elapsed);
+        total += elapsed;
+    }
+    result.nanosecondsPerSample = best * 1e9 / size;
+    return result;
+}
+
+// The pipeline of task_6 on a mono 16-bit file of the given number of frames, one stage at a time: reading the WAV
+// file, the forward transform, the filter, the inverse transform and writing the WAV file. The file is made up of
+// noise and lives in directory. Plan construction is measured too, since every new size pays for it once.
+template<typename Real>
+std::vector<StageResult> MeasurePipeline(const uint32_t& size, const std::string& directory, const double& minimumTime) {
+    const double sampleRate = 44100;
+    WavFormat format;
+    format.sampleRate = sampleRate;
+    std::string inputPath = directory + "/benchmark_input.wav";
+    std::string outputPath = directory + "/benchmark_output.wav";
+    {
+        std::vector<double> noise(size);
+        std::mt19937 generator(size);
+        std::uniform_real_distribution<double> distribution(-0.5, 0.5);
+        for (double& sample : noise)
+            sample = distribution(generator);
+        WavWriter input(inputPath, format, size);
+        input.SetChannel(0, noise.data(), size);
+    }
+    LowPassFilter filter(sampleRate / 15);
+    std::unique_ptr<BasicRealFFTPlan<Real>> plan;
+    std::vector<Real> samples;
+    BasicComplexArray<Real> spectrum;
+    BasicComplexArray<Real> filtered;
+    std::vector<Real> output;
+    std::vector<StageResult> results;
+    results.push_back(Measure("plan", size, minimumTime, [&] { plan.reset(); }, [&] {
+        plan.reset(new BasicRealFFTPlan<Real>(BasicRealFFTPlan<Real>::GetFastSize(size)));
+    }));
+    results.push_back(Measure("read", size, minimumTime, [] {}, [&] {
+        WavReader input(inputPath);
+        samples.assign(plan->GetSize(), Real(0));
+        input.GetChannel(0).Read(samples.data());
+    }));
+    results.push_back(Measure("fft", size, minimumTime, [] {}, [&] { plan->Forward(samples, spectrum); }));
+    results.push_back(Measure("filter", size, minimumTime, [&] { filtered = spectrum; }, [&] {
+        filter.Apply(filtered, plan->GetSize(), sampleRate);
+    }));
+    results.push_back(Measure("ifft", size, minimumTime, [&] { filtered = spectrum; }, [&] {
+        plan->Inverse(filtered, output);
+    }));
+    results.push_back(Measure("write", size, minimumTime, [] {}, [&] {
+        WavWriter writer(outputPath, format, size);
+        writer.SetChannel(0, output.data(), size);
+    }));
+    remove(inputPath.c_str());
+    remove(outputPath.c_str());
+    for (StageResult& result : results) {
+        result.precision = (sizeof(Real) == sizeof(float) ? "float" : "double");
+        result.peakResidentSize = GetPeakResidentSize();
+    }
+    return results;
+}
+
+void WriteResults(std::ostream& output, const std::vector<StageResult>& results) {
+    output << resultsHeader << std::endl;
+    for (const StageResult& result : results)
+        output << result.precision << ',' << result.size << ',' << result.stage << ',' << std::fixed << std::setprecision(4)
+               << result.nanosecondsPerSample << ',' << result.allocationCount << ',' << result.allocatedSize << ','
+               << result.peakResidentSize << std::endl;
+}
+std::vector<StageResult> ReadResults(const std::string& path) {
+    std::ifstream input(path);
+    std::string line;
+    if (!input || !std::getline(input, line) || line != resultsHeader)
+        throw std::runtime_error(path + " is not a benchmark result file.");
+    std::vector<StageResult> results;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        StageResult result;
+        std::string size, nanoseconds, allocations, allocated, peak;
+        std::getline(fields, result.precision, ',');
+        std::getline(fields, size, ',');
+        std::getline(fields, result.stage, ',');
+        std::getline(fields, nanoseconds, ',');
+        std::getline(fields, allocations, ',');
+        std::getline(fields, allocated, ',');
+        std::getline(fields, peak, ',');
+        if (!fields)
+            throw std::runtime_error(path + " has a malformed line: " + line);
+        result.size = std::stoul(size);
+        result.nanosecondsPerSample = std::stod(nanoseconds);
+        result.allocationCount = std::stoull(allocations);
+        result.allocatedSize = std::stoull(allocated);
+        result.peakResidentSize = std::stoull(peak);
+        results.push_back(result);
+    }
+    return results;
+}
+
+// Prints every stage present in both files with its time before and after, and marks the ones that got slower by
+// more than threshold. Returns the number of marked stages.
+uint32_t CompareResults(const std::vector<StageResult>& baseline, const std::vector<StageResult>& current,
+                        const double& threshold) {
+    std::map<std::string, const StageResult*> baselineStages;
+    for (const StageResult& result : baseline)
+        baselineStages[result.precision + ',' + std::to_string(result.size) + ',' + result.stage] = &result;
+    uint32_t regressionCount = 0;
+    for (const StageResult& result : current) {
+        auto found = baselineStages.find(result.precision + ',' + std::to_string(result.size) + ',' + result.stage);
+        if (found == baselineStages.end())
+            continue;
+        double ratio = result.nanosecondsPerSample / found->second->nanosecondsPerSample;
+        bool isRegression = ratio > 1 + threshold;
+        regressionCount += isRegression;
+        std::cout << std::left << std::setw(7) << result.precision << std::right << std::setw(10) << result.size << ' '
+                  << std::left << std::setw(7) << result.stage << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << found->second->nanosecondsPerSample << " ->" << std::setw(10)
+                  << result.nanosecondsPerSample << " ns/sample  x" << std::setprecision(2) << ratio
+                  << (isRegression ? "  SLOWER" : "") << std::endl;
+    }
+    return regressionCount;
+}
+
+// Sizes 2^10 to 2^maxPower and lengths with other factors up to the same bound: audio-typical ones, 3- and 5-smooth
+// ones and ones with a large prime factor that go through Bluestein.
+std::vector<uint32_t> GetBenchmarkSizes(const uint32_t& maxPower) {
+    std::vector<uint32_t> sizes;
+    for (uint32_t power = 10; power <= maxPower; ++power)
+        sizes.push_back(1u << power);
+    for (uint32_t size : {1000u, 20000u, 44100u, 100000u, 441000u, 1000000u, 1048577u, 1594323u, 1953125u, 4410000u,
+                          10000019u})
+        if (size <= (1u << maxPower))
+            sizes.push_back(size);
+    std::sort(sizes.begin(), sizes.end());
+    return sizes;
+}
+
+// benchmark [--float] [--threads N] [--max-power P] [--min-time MS] [--directory DIR] [results.csv]: runs every stage
+// over the size sweep, prints a table and saves the results as CSV (default: benchmark.csv).
+// benchmark --compare baseline.csv results.csv [--threshold PERCENT]: compares two result files and exits with 1 if a
+// stage got slower by more than the threshold (default: 10%).
+int32_t main(int32_t argc, char** argv) {
+    try {
+        std::vector<std::string> arguments(argv + 1, argv + argc);
+        bool isSinglePrecision = false;
+        unsigned int threadCount = 1;
+        uint32_t maxPower = 24;
+        double minimumTime = 0.2;
+        double threshold = 0.1;
+        std::string directory = ".";
+        std::vector<std::string> paths;
+        bool isComparison = false;
+        for (size_t index = 0; index < arguments.size(); ++index) {
+            std::string option = arguments[index];
+            auto getValue = [&]() {
+                if (++index == arguments.size())
+                    throw std::runtime_error("Missing value for " + option + ".");
+                return arguments[index];
+            };
+            if (option == "--float")
+                isSinglePrecision = true;
+            else if (option == "--threads")
+                threadCount = std::stoul(getValue());
+            else if (option == "--max-power")
+                maxPower = std::min(std::max(std::stoul(getValue()), 10ul), 28ul);
+            else if (option == "--min-time")
+                minimumTime = std::stod(getValue()) / 1000;
+            else if (option == "--directory")
+                directory = getValue();
+            else if (option == "--threshold")
+                threshold = std::stod(getValue()) / 100;
+            else if (option == "--compare")
+                isComparison = true;
+            else if (option.compare(0, 2, "--") == 0)
+                throw std::runtime_error("Unknown option " + option + ".");
+            else
+                paths.push_back(option);
+        }
+        if (isComparison) {
+            if (paths.size() != 2) {
+                std::cerr << "Usage: " << argv[0] << " --compare baseline.csv results.csv [--threshold PERCENT]" << std::endl;
+                return 1;
+            }
+            return (CompareResults(ReadResults(paths[0]), ReadResults(paths[1]), threshold) == 0 ? 0 : 1);
+        }
+        if (paths.size() > 1) {
+            std::cerr << "Usage: " << argv[0] << " [--float] [--threads N] [--max-power P] [--min-time MS]"
+                      << " [--directory DIR] [results.csv]" << std::endl;
+            return 1;
+        }
+        SetParallelism(threadCount);
+        std::vector<StageResult> results;
+        std::cout << "precision      size stage   ns/sample  allocations       bytes  peak RSS kB" << std::endl;
+        for (uint32_t size : GetBenchmarkSizes(maxPower)) {
+            std::vector<StageResult> sizeResults = (isSinglePrecision ? MeasurePipeline<float>(size, directory, minimumTime)
+                                                                      : MeasurePipeline<double>(size, directory, minimumTime));
+            for (const StageResult& result : sizeResults)
+                std::cout << std::left << std::setw(9) << result.precision << std::right << std::setw(10) << result.size
+                          << ' ' << std::left << std::setw(7) << result.stage << std::right << std::fixed
+                          << std::setprecision(3) << std::setw(10) << result.nanosecondsPerSample << std::setw(13)
+                          << result.allocationCount << std::setw(12) << result.allocatedSize << std::setw(13)
+                          << result.peakResidentSize << std::endl;
+            results.insert(results.end(), sizeResults.begin(), sizeResults.end());
+        }
+        std::string resultsPath = (paths.empty() ? "benchmark.csv" : paths[0]);
+        std::ofstream output(resultsPath);
+        WriteResults(output, results);
+        if (!output)
+            throw std::runtime_error("Cannot write " + resultsPath + ".");
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "../Common/fft.h"
+
+// Zero-phase spectral mask: a real gain for every frequency in Hz. Each edge is either sharp or a raised-cosine
+// ramp of the given rolloff width centred on the edge frequency.
+class SpectralFilter {
+    public:
+        virtual ~SpectralFilter() = default;
+        virtual double GetGain(const double&) const = 0;
+        // Scales bins 0..size/2 of a size-point transform of a signal sampled at sampleRate by their gains.
+        template<typename Real>
+        void Apply(BasicComplexArray<Real>&, const uint32_t&, const double&) const;
+        // The mask as a linear-phase FIR of the given (odd) length for the same sample rate, by frequency sampling
+        // on a fine grid and a Blackman window. The filter delay is (kernelSize - 1) / 2 samples.
+        std::vector<double> GetKernel(const uint32_t&, const double&) const;
+    protected:
+        // 1 below the edge, 0 above it.
+        static double GetEdgeGain(const double&, const double&, const double&);
+};
+template<typename Real>
+void SpectralFilter::Apply(BasicComplexArray<Real>& spectrum, const uint32_t& size, const double& sampleRate) const {
+    for (uint32_t k = 0; k < spectrum.GetSize(); ++k) {
+        double gain = GetGain(k * sampleRate / size);
+        if (gain != 1) {
+            spectrum.re[k] *= gain;
+            spectrum.im[k] *= gain;
+        }
+    }
+}
+std::vector<double> SpectralFilter::GetKernel(const uint32_t& kernelSize, const double& sampleRate) const {
+    uint32_t gridSize = 1;
+    while (gridSize < 64 * kernelSize)
+        gridSize *= 2;
+    RealFFTPlan plan(gridSize);
+    ComplexArray spectrum(gridSize / 2 + 1);
+    std::fill(spectrum.re.begin(), spectrum.re.end(), 1.0);
+    Apply(spectrum, gridSize, sampleRate);
+    std::vector<double> response;
+    plan.Inverse(spectrum, response);
+    // The response is centred on sample 0 of the grid; the kernel is its window around it.
+    std::vector<double> kernel(kernelSize);
+    double pi = acos(-1);
+    int32_t center = (kernelSize - 1) / 2;
+    for (uint32_t i = 0; i < kernelSize; ++i) {
+        double window = 0.42 - 0.5 * cos(2 * pi * i / (kernelSize - 1)) + 0.08 * cos(4 * pi * i / (kernelSize - 1));
+        kernel[i] = response[(static_cast<int32_t>(i) - center + gridSize) % gridSize] * window;
+    }
+    return kernel;
+}
+double SpectralFilter::GetEdgeGain(const double& frequency, const double& edge, const double& rolloff) {
+    if (rolloff <= 0)
+        return (frequency < edge ? 1 : 0);
+    double position = (frequency - (edge - rolloff / 2)) / rolloff;
+    if (position <= 0)
+        return 1;
+    if (position >= 1)
+        return 0;
+    return (1 + cos(acos(-1) * position)) / 2;
+}
+
+class LowPassFilter : public SpectralFilter {
+    public:
+        explicit LowPassFilter(const double&, const double& = 0);
+        double GetGain(const double&) const override;
+    private:
+        double cutoff;
+        double rolloff;
+};
+LowPassFilter::LowPassFilter(const double& cutoff, const double& rolloff) : cutoff(cutoff), rolloff(rolloff) {
+    if (cutoff <= 0 || rolloff < 0)
+        throw std::runtime_error("Low-pass cutoff must be positive.");
+}
+double LowPassFilter::GetGain(const double& frequency) const {
+    return GetEdgeGain(frequency, cutoff, rolloff);
+}
+
+class HighPassFilter : public SpectralFilter {
+    public:
+        explicit HighPassFilter(const double&, const double& = 0);
+        double GetGain(const double&) const override;
+    private:
+        double cutoff;
+        double rolloff;
+};
+HighPassFilter::HighPassFilter(const double& cutoff, const double& rolloff) : cutoff(cutoff), rolloff(rolloff) {
+    if (cutoff < 0 || rolloff < 0)
+        throw std::runtime_error("High-pass cutoff must not be negative.");
+}
+double HighPassFilter::GetGain(const double& frequency) const {
+    return 1 - GetEdgeGain(frequency, cutoff, rolloff);
+}
+
+class BandPassFilter : public SpectralFilter {
+    public:
+        BandPassFilter(const double&, const double&, const double& = 0);
+        double GetGain(const double&) const override;
+    private:
+        double low;
+        double high;
+        double rolloff;
+};
+BandPassFilter::BandPassFilter(const double& low, const double& high, const double& rolloff)
+    : low(low), high(high), rolloff(rolloff) {
+    if (low < 0 || high <= low || rolloff < 0)
+        throw std::runtime_error("Band-pass edges must satisfy 0 <= low < high.");
+}
+double BandPassFilter::GetGain(const double& frequency) const {
+    return (1 - GetEdgeGain(frequency, low, rolloff)) * GetEdgeGain(frequency, high, rolloff);
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+// Wall-clock totals per named stage, kept in order of first use. Stages running on several threads at once add up,
+// so a total is the time spent in the stage rather than its share of the elapsed time.
+class StageTimings {
+    public:
+        struct Stage {
+            std::string name;
+            uint64_t nanoseconds = 0;
+            uint32_t callCount = 0;
+        };
+        // Timings are collected only while the shared instance exists.
+        static std::unique_ptr<StageTimings>& GetInstance();
+        void Add(const std::string&, const uint64_t&);
+        // Samples (frames times channels) that went through the pipeline, for the per-sample costs.
+        void AddSamples(const uint64_t&);
+        std::vector<Stage> GetStages() const;
+        // One line per stage with its total, its cost per sample and its number of calls.
+        void Print(std::ostream&) const;
+    private:
+        mutable std::mutex mutex;
+        std::vector<Stage> stages;
+        uint64_t sampleCount = 0;
+};
+// Adds its own lifetime to a stage of the shared timings, if there are any.
+class ScopedStage {
+    public:
+        explicit ScopedStage(const char*);
+        ~ScopedStage();
+        ScopedStage(const ScopedStage&) = delete;
+        ScopedStage& operator=(const ScopedStage&) = delete;
+    private:
+        const char* name;
+        StageTimings* timings;
+        std::chrono::steady_clock::time_point start;
+};
+
+std::unique_ptr<StageTimings>& StageTimings::GetInstance() {
+    static std::unique_ptr<StageTimings> timings;
+    return timings;
+}
+void StageTimings::Add(const std::string& name, const uint64_t& nanoseconds) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Stage>::iterator stage = stages.begin();
+    while (stage != stages.end() && stage->name != name)
+        ++stage;
+    if (stage == stages.end()) {
+        stage = stages.insert(stage, Stage());
+        stage->name = name;
+    }
+    stage->nanoseconds += nanoseconds;
+    ++stage->callCount;
+}
+void StageTimings::AddSamples(const uint64_t& count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sampleCount += count;
+}
+std::vector<StageTimings::Stage> StageTimings::GetStages() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stages;
+}
+void StageTimings::Print(std::ostream& output) const {
+    uint64_t sampleCount;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sampleCount = this->sampleCount;
+    }
+    for (const Stage& stage : GetStages())
+        output << std::left << std::setw(10) << stage.name << std::right << std::fixed << std::setprecision(3)
+               << std::setw(12) << stage.nanoseconds / 1e6 << " ms" << std::setw(10)
+               << static_cast<double>(stage.nanoseconds) / std::max<uint64_t>(sampleCount, 1) << " ns/sample"
+               << std::setw(6) << stage.callCount << " calls" << std::endl;
+}
+
+ScopedStage::ScopedStage(const char* name) : name(name), timings(StageTimings::GetInstance().get()) {
+    if (timings != nullptr)
+        start = std::chrono::steady_clock::now();
+}
+ScopedStage::~ScopedStage() {
+    if (timings != nullptr)
+        timings->Add(name, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+// Largest resident set of the process so far, in kilobytes.
+uint64_t GetPeakResidentSize() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+#endif
@@ -1,178 +1,346 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <iostream>
 #include <cmath>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
+#include "../Common/convolution.h"
+#include "filter.h"
+#include "profile.h"
+#include "wav.h"
 
-uint32_t GetNearestTwoPower(uint32_t n) {
-    uint32_t nearestTwoPower = 1;
-    while (nearestTwoPower < n)
-        nearestTwoPower *= 2;
-    return nearestTwoPower;
-}
-
-struct Complex {
-    Complex() = default;
-    Complex(const double&);
-    Complex(const double&, const double&);
-    double re = 0;
-    double im = 0;
-    Complex& operator+=(const Complex&);
-    Complex& operator*=(const Complex&);
-    Complex& operator/=(const Complex&);
-    Complex GetReverse() const;
-    friend std::ostream& operator<<(std::ostream&, const Complex&);
+// Command-line choice of filter and precision, shared by every mode.
+struct FilterSettings {
+    // "lowpass", "highpass" or "bandpass". A low-pass without a cutoff keeps the lowest 1/15 of the sample rate.
+    std::string type = "lowpass";
+    double cutoff = 0;
+    double low = 0;
+    double high = 0;
+    double rolloff = 0;
+    bool isSinglePrecision = false;
+    std::unique_ptr<SpectralFilter> GetFilter(const double&) const;
 };
-Complex::Complex(const double& re) : re(re) {}
-Complex::Complex(const double& re, const double& im) : re(re), im(im) {}
-Complex& Complex::operator+=(const Complex& num) {
-    re += num.re;
-    im += num.im;
-    return *this;
-}
-Complex operator+(const Complex& num1, const Complex& num2) {
-    Complex copy = num1;
-    copy += num2;
-    return copy;
-}
-Complex& Complex::operator*=(const Complex& num) {
-    double reCopy = re;
-    double imCopy = im;
-    re = reCopy * num.re - imCopy * num.im;
-    im = reCopy * num.im + imCopy * num.re;
-    return *this;
-}
-Complex operator*(const Complex& num1, const Complex& num2) {
-    Complex copy = num1;
-    copy *= num2;
-    return copy;
-}
-Complex& Complex::operator/=(const Complex& num) {
-    return *this *= num.GetReverse();
-}
-Complex operator/(const Complex& num1, const Complex& num2) {
-    Complex copy = num1;
-    copy /= num2;
-    return copy;
-}
-Complex Complex::GetReverse() const {
-    Complex copy = *this;
-    copy.re = re / (re * re + im * im);
-    copy.im = -im / (re * re + im * im);
-    return copy;
-}
-std::ostream& operator<<(std::ostream& os, const Complex& complexNum) {
-    os << complexNum.re << " + " << complexNum.im << "i";
-    return os;
+std::unique_ptr<SpectralFilter> FilterSettings::GetFilter(const double& sampleRate) const {
+    if (type == "highpass")
+        return std::unique_ptr<SpectralFilter>(new HighPassFilter(cutoff, rolloff));
+    if (type == "bandpass")
+        return std::unique_ptr<SpectralFilter>(new BandPassFilter(low, high, rolloff));
+    return std::unique_ptr<SpectralFilter>(new LowPassFilter(cutoff > 0 ? cutoff : sampleRate / 15, rolloff));
 }
 
-std::vector<Complex> GetRootsFromOne(const uint32_t& rootCount, const bool& isReversed) {
-    std::vector<Complex> roots;
-    double pi = acos(-1);
-    for (uint32_t i = 0; i < rootCount; ++i)
-        roots.push_back({cos((isReversed ? -1 : 1) * 2 * pi * i / rootCount), sin((isReversed ? -1 : 1) * 2 * pi * i / rootCount)});
-    return roots;
+template<typename Real>
+BasicComplexArray<Real> FFT(const WavChannelView& inputData, const BasicRealFFTPlan<Real>& plan) {
+    std::vector<Real> inputDataVector(plan.GetSize());
+    {
+        ScopedStage stage("read");
+        inputData.Read(inputDataVector.data());
+    }
+    ScopedStage stage("fft");
+    BasicComplexArray<Real> inputDataFFT;
+    plan.Forward(inputDataVector, inputDataFFT);
+    return inputDataFFT;
 }
 
-struct WavFileHeader {
-    int8_t chunkId[4];
-    uint32_t chunkSize;
-    int8_t format[4];
-    int8_t subchunk1Id[4];
-    uint32_t subchunk1Size;
-    uint16_t audioFormat;
-    uint16_t numChannels;
-    uint32_t sampleRate;
-    uint32_t byteRate;
-    uint16_t blockAlign;
-    uint16_t bitsPerSample;
-    int8_t subchunk2Id[4];
-    uint32_t subchunk2Size;
-};
-
-std::vector<Complex> FFTRecursion(const std::vector<Complex>& inputData, std::vector<Complex>& oneRRoots, const uint32_t& inputDataSize) {
-    if (inputData.size() == 1)
-        return inputData;
-    std::vector<Complex> inputDataFFT(inputData.size());
-    std::vector<std::vector<Complex>> splittedData(2, std::vector<Complex>(inputData.size() / 2));
-    for (uint32_t i = 0; i < inputData.size(); ++i)
-        splittedData[i % 2 == 0 ? 0 : 1][i / 2] = inputData[i];
-    std::vector<std::vector<Complex>> splittedDataFFT(2, std::vector<Complex>(inputData.size() / 2));
-    splittedDataFFT[0] = FFTRecursion(splittedData[0], oneRRoots, inputDataSize);
-    splittedDataFFT[1] = FFTRecursion(splittedData[1], oneRRoots, inputDataSize);
-    for (uint32_t i = 0; i < inputDataFFT.size(); ++i)
-        inputDataFFT[i] = splittedDataFFT[0][i % splittedDataFFT[0].size()] + splittedDataFFT[1][i % splittedDataFFT[1].size()] * oneRRoots[i * (inputDataSize / splittedDataFFT[1].size()) % oneRRoots.size()];
-    return inputDataFFT;
+template<typename Real>
+std::vector<Real> IFFT(BasicComplexArray<Real>& modifiedData, const BasicRealFFTPlan<Real>& plan) {
+    ScopedStage stage("ifft");
+    std::vector<Real> outputData;
+    plan.Inverse(modifiedData, outputData);
+    return outputData;
 }
 
-std::vector<Complex> FFT(const int16_t* inputData, uint32_t inputDataSize) {
-    std::vector<Complex> inputDataVector;
-    uint32_t i = 0;
-    for (; i < inputDataSize; ++i)
-        inputDataVector.push_back(Complex(static_cast<double>(inputData[i])));
-    uint32_t nearestTwoPower = GetNearestTwoPower(inputDataVector.size());
-    for (; i < nearestTwoPower; ++i)
-        inputDataVector.push_back({0});
-    std::vector<Complex> oneRRoots = GetRootsFromOne(inputDataVector.size(), true);
-    return FFTRecursion(inputDataVector, oneRRoots, inputDataVector.size());
+// The shared plan for a whole-file transform of frameCount frames. Lengths with only small prime factors are
+// transformed exactly; others are padded to the cheapest larger size of the form 2^a 3^b 5^c 7^d rather than to the
+// next power of two.
+template<typename Real>
+const BasicRealFFTPlan<Real>& GetPlan(const uint32_t& frameCount) {
+    ScopedStage stage("plan");
+    return GetSharedRealFFTPlan<Real>(BasicRealFFTPlan<Real>::GetFastSize(frameCount));
 }
 
-std::vector<Complex> Modify(const std::vector<Complex>& fftData) {
-    std::vector<Complex> modifiedData = fftData;
-    for (uint32_t i = 1 * modifiedData.size() / 15; i < modifiedData.size(); ++i)
-        modifiedData[i] = Complex(0.0, 0.0);
-    return modifiedData;
+// One channel through the whole-file transform and the filter; the result is as long as the plan.
+template<typename Real>
+std::vector<Real> GetFilteredChannel(const WavChannelView& inputData, const BasicRealFFTPlan<Real>& plan,
+                                     const SpectralFilter& filter, const double& sampleRate) {
+    BasicComplexArray<Real> inputDataFFT = FFT(inputData, plan);
+    {
+        ScopedStage stage("filter");
+        filter.Apply(inputDataFFT, plan.GetSize(), sampleRate);
+    }
+    return IFFT(inputDataFFT, plan);
 }
 
-std::vector<Complex> IFFTRecursion(const std::vector<Complex>& modifiedData, const std::vector<Complex>& oneRoots, const uint32_t& modifiedDataSize) {
-    if (modifiedData.size() == 1)
-        return modifiedData;
-    std::vector<Complex> modifiedDataIFFT(modifiedData.size());
-    std::vector<std::vector<Complex>> splittedData(2, std::vector<Complex>(modifiedData.size() / 2));
-    for (uint32_t i = 0; i < modifiedData.size(); ++i)
-        splittedData[i % 2 == 0 ? 0 : 1][i / 2] = modifiedData[i];
-    std::vector<std::vector<Complex>> splittedDataIFFT(2, std::vector<Complex>(modifiedData.size() / 2));
-    splittedDataIFFT[0] = IFFTRecursion(splittedData[0], oneRoots, modifiedDataSize);
-    splittedDataIFFT[1] = IFFTRecursion(splittedData[1], oneRoots, modifiedDataSize);
-    for (uint32_t i = 0; i < modifiedDataIFFT.size(); ++i)
-        modifiedDataIFFT[i] = splittedDataIFFT[0][i % splittedDataIFFT[0].size()] + splittedDataIFFT[1][i % splittedDataIFFT[1].size()] * oneRoots[i * (modifiedDataSize / splittedDataIFFT[1].size()) % oneRoots.size()];
-    return modifiedDataIFFT;
+// Filters every channel of the input as one transform over the whole file, the channels as parallel tasks.
+template<typename Real>
+void WriteOutputData(const WavReader& input, const std::string& outputPath, const FilterSettings& settings) {
+    const WavFormat& format = input.GetFormat();
+    uint32_t frameCount = input.GetFrameCount();
+    if (StageTimings::GetInstance())
+        StageTimings::GetInstance()->AddSamples(static_cast<uint64_t>(frameCount) * format.numChannels);
+    WavWriter output(outputPath, format, frameCount);
+    std::unique_ptr<SpectralFilter> filter = settings.GetFilter(format.sampleRate);
+    const BasicRealFFTPlan<Real>& plan = GetPlan<Real>(frameCount);
+    TaskGroup channels;
+    for (uint16_t channel = 0; channel < format.numChannels; ++channel)
+        channels.Run([&, channel] {
+            std::vector<Real> outputData = GetFilteredChannel(input.GetChannel(channel), plan, *filter, format.sampleRate);
+            ScopedStage stage("write");
+            output.SetChannel(channel, outputData.data(), frameCount);
+        });
+    channels.Wait();
+}
+void WriteOutputData(const WavReader& input, const std::string& outputPath, const FilterSettings& settings) {
+    if (settings.isSinglePrecision)
+        WriteOutputData<float>(input, outputPath, settings);
+    else
+        WriteOutputData<double>(input, outputPath, settings);
 }
 
-int16_t* IFFT(const std::vector<Complex>& modifiedData) {
-    int16_t* outputData = new int16_t[modifiedData.size()];
-    std::vector<Complex> oneRoots = GetRootsFromOne(modifiedData.size(), false);
-    std::vector<Complex> IFFTModifiedData = IFFTRecursion(modifiedData, oneRoots, modifiedData.size());
-    for (uint32_t i = 0; i < modifiedData.size(); ++i)
-        outputData[i] = std::round(IFFTModifiedData[i].re) / modifiedData.size();
-    return outputData;
+// Accuracy of the float engine: runs both precisions over every channel and prints the signal-to-noise ratio of the
+// float result against the double one, and how many 16-bit output samples come out different.
+void PrintPrecisionReport(const WavReader& input, const FilterSettings& settings) {
+    const WavFormat& format = input.GetFormat();
+    uint32_t frameCount = input.GetFrameCount();
+    std::unique_ptr<SpectralFilter> filter = settings.GetFilter(format.sampleRate);
+    const RealFFTPlan& plan = GetPlan<double>(frameCount);
+    const BasicRealFFTPlan<float>& floatPlan = GetPlan<float>(frameCount);
+    for (uint16_t channel = 0; channel < format.numChannels; ++channel) {
+        std::vector<double> reference = GetFilteredChannel(input.GetChannel(channel), plan, *filter, format.sampleRate);
+        std::vector<float> result = GetFilteredChannel(input.GetChannel(channel), floatPlan, *filter, format.sampleRate);
+        double signal = 0;
+        double noise = 0;
+        uint32_t differentCount = 0;
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            signal += reference[i] * reference[i];
+            noise += (reference[i] - result[i]) * (reference[i] - result[i]);
+            auto toInt16 = [](double value) { return std::max(-32768.0, std::min(32767.0, std::round(value * 32768))); };
+            differentCount += (toInt16(reference[i]) != toInt16(result[i]));
+        }
+        std::cout << "channel " << channel << ": SNR " << 10 * log10(signal / noise) << " dB, " << differentCount
+                  << " of " << frameCount << " 16-bit samples differ" << std::endl;
+    }
 }
 
-int16_t* GetOutputData(int16_t* inputData, uint32_t inputDataSize) {
-    std::vector<Complex> inputDataFFT = FFT(inputData, inputDataSize);
-    std::vector<Complex> modifiedData = Modify(inputDataFFT);
-    int16_t* outputData = IFFT(modifiedData);
-    return outputData;
+// Filters every input into outputDirectory under the same file name, files and their channels as parallel tasks.
+// A file that fails is reported and skipped; returns the number of failures.
+uint32_t WriteBatchOutputData(const std::string& outputDirectory, const std::vector<std::string>& inputPaths,
+                              const FilterSettings& settings) {
+    std::atomic<uint32_t> failureCount(0);
+    std::mutex errorMutex;
+    TaskGroup files;
+    for (const std::string& inputPath : inputPaths)
+        files.Run([&, inputPath] {
+            try {
+                std::string fileName = inputPath.substr(inputPath.find_last_of('/') + 1);
+                WavReader input(inputPath);
+                WriteOutputData(input, outputDirectory + "/" + fileName, settings);
+            } catch (const std::exception& exception) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                std::cerr << inputPath << ": " << exception.what() << std::endl;
+                ++failureCount;
+            }
+        });
+    files.Wait();
+    return failureCount;
 }
 
-int32_t main() {
-    FILE* wavInputFile = fopen("/home/user/Documents/Study/Cpp/ProblemSolver/Documents/input.wav", "r");
-    WavFileHeader wavFileHeader;
-    fread(&wavFileHeader, sizeof(wavFileHeader), 1, wavInputFile);
-    int8_t* data = new int8_t[wavFileHeader.subchunk2Size];
-    int16_t* inputData = reinterpret_cast<int16_t*>(data);
-    uint32_t inputDataSize = wavFileHeader.subchunk2Size / 2;
-    fread(data, wavFileHeader.subchunk2Size, 1, wavInputFile);
-    fclose(wavInputFile);
-    
-    int16_t* outputData = GetOutputData(inputData, inputDataSize);
+const uint32_t streamTransformSize = 8192;
+const uint32_t streamKernelSize = 1025;
+const uint32_t streamBlockSize = streamTransformSize - streamKernelSize + 1;
+const uint32_t streamBufferSize = 1 << 20;
 
-    FILE* wavOutputFile = fopen("/home/user/Documents/Study/Cpp/ProblemSolver/Documents/output.wav", "w");
-    fwrite(&wavFileHeader, sizeof(wavFileHeader), 1, wavOutputFile);
-    fwrite(outputData, inputDataSize * 2, 1, wavOutputFile);
-    fclose(wavOutputFile);
+// Overlap-add filtering of up to frameCount frames from input to output, one block at a time and every channel on its
+// own. Memory does not depend on the length of the stream and output is written as soon as each block is read. The
+// filter delay of (streamKernelSize - 1) / 2 frames is removed, so the output is aligned with and as long as the
+// input. The filter is the FIR counterpart of the whole-file one. Returns the number of frames written, which falls
+// short of frameCount when the input ends early.
+template<typename Real>
+uint32_t StreamOutputData(FILE* input, FILE* output, const WavFormat& format, uint32_t frameCount,
+                      const FilterSettings& settings) {
+    if (StageTimings::GetInstance())
+        StageTimings::GetInstance()->AddSamples(static_cast<uint64_t>(frameCount) * format.numChannels);
+    std::vector<double> kernel = settings.GetFilter(format.sampleRate)->GetKernel(streamKernelSize, format.sampleRate);
+    BasicFIRConvolution<Real> convolution(kernel, streamTransformSize);
 
-    delete [] inputData;
-    delete [] outputData;
+    uint32_t blockAlign = format.GetBlockAlign();
+    uint32_t sampleSize = format.bitsPerSample / 8;
+    std::vector<uint8_t> inputBlock(streamBlockSize * blockAlign);
+    std::vector<uint8_t> outputBlock(streamBlockSize * blockAlign);
+    std::vector<Real> samples(streamBlockSize);
+    std::vector<Real> block;
+    std::vector<std::vector<Real>> tails(format.numChannels, std::vector<Real>(streamKernelSize - 1));
+    uint32_t delay = (streamKernelSize - 1) / 2;
+    // Output frames of the current block, per channel, before the delay is cut off.
+    std::vector<std::vector<Real>> filtered(format.numChannels, std::vector<Real>(streamBlockSize));
+    uint32_t writtenCount = 0;
+    auto write = [&](uint32_t count) {
+        ScopedStage stage("write");
+        uint32_t skipped = std::min(delay, count);
+        delay -= skipped;
+        for (uint16_t channel = 0; channel < format.numChannels; ++channel)
+            format.SetSamples(outputBlock.data() + channel * sampleSize, count - skipped, filtered[channel].data() + skipped);
+        if (fwrite(outputBlock.data(), blockAlign, count - skipped, output) != count - skipped)
+            throw std::runtime_error("Output write failed.");
+        writtenCount += count - skipped;
+    };
+    while (frameCount > 0) {
+        uint32_t count;
+        {
+            ScopedStage stage("read");
+            count = fread(inputBlock.data(), blockAlign, std::min(streamBlockSize, frameCount), input);
+        }
+        if (count == 0)
+            break;
+        frameCount -= count;
+        for (uint16_t channel = 0; channel < format.numChannels; ++channel) {
+            std::vector<Real>& tail = tails[channel];
+            {
+                ScopedStage stage("read");
+                format.GetSamples(inputBlock.data() + channel * sampleSize, count, samples.data());
+            }
+            {
+                ScopedStage stage("convolve");
+                convolution.Convolve(samples.data(), count, block);
+            }
+            for (uint32_t i = 0; i < tail.size(); ++i)
+                block[i] += tail[i];
+            std::copy(block.begin(), block.begin() + count, filtered[channel].begin());
+            std::copy(block.begin() + count, block.begin() + count + tail.size(), tail.begin());
+        }
+        write(count);
+    }
+    for (uint16_t channel = 0; channel < format.numChannels; ++channel)
+        std::copy(tails[channel].begin(), tails[channel].begin() + (streamKernelSize - 1) / 2, filtered[channel].begin());
+    write((streamKernelSize - 1) / 2);
+    return writtenCount;
+}
+
+// Streams the WAV file on input through the filter to output. The header goes out first with the size the input
+// declares; when the input ends early, the sizes are rewritten at the end if output can seek, as the whole-file mode
+// would clip the same input, and a stream that cannot be patched is an error.
+void StreamWavFile(FILE* input, FILE* output, const FilterSettings& settings) {
+    uint32_t dataSize;
+    WavFormat format = ReadWavHeader(input, dataSize);
+    uint32_t frameCount = dataSize / format.GetBlockAlign();
+    std::vector<uint8_t> header = GetWavHeader(format, frameCount * format.GetBlockAlign());
+    if (fwrite(header.data(), 1, header.size(), output) != header.size())
+        throw std::runtime_error("Output write failed.");
+    uint32_t writtenCount = (settings.isSinglePrecision
+                             ? StreamOutputData<float>(input, output, format, frameCount, settings)
+                             : StreamOutputData<double>(input, output, format, frameCount, settings));
+    uint32_t writtenSize = writtenCount * format.GetBlockAlign();
+    if (writtenSize % 2 == 1 && fputc(0, output) == EOF)
+        throw std::runtime_error("Output write failed.");
+    if (writtenCount != frameCount) {
+        if (fflush(output) != 0 || fseek(output, 0, SEEK_SET) != 0)
+            throw std::runtime_error("WAV stream is truncated.");
+        header = GetWavHeader(format, writtenSize);
+        if (fwrite(header.data(), 1, header.size(), output) != header.size())
+            throw std::runtime_error("Output write failed.");
+    }
+    if (fflush(output) != 0)
+        throw std::runtime_error("Output write failed.");
+}
 
+// task_6 [options] input.wav output.wav: filters a whole file.
+// task_6 [options] --batch outputDirectory input.wav...: filters many files into one directory.
+// task_6 [options] --stream [input [output]]: the same block by block, "-" or no path means stdin/stdout.
+// task_6 [options] --snr input.wav: reports the accuracy of --float against double precision.
+// Options: --threads N (default: all cores), --lowpass HZ (default: 1/15 of the sample rate), --highpass HZ,
+// --bandpass LOW HIGH, --rolloff HZ (width of raised-cosine edges, default: sharp), --float (single precision),
+// --timings (prints the time of every stage to stderr when done).
+int32_t main(int32_t argc, char** argv) {
+    try {
+        std::vector<std::string> arguments(argv + 1, argv + argc);
+        unsigned int threadCount = std::thread::hardware_concurrency();
+        FilterSettings settings;
+        std::string mode;
+        size_t index = 0;
+        for (; index < arguments.size() && arguments[index].compare(0, 2, "--") == 0; ++index) {
+            std::string option = arguments[index];
+            auto getValue = [&]() {
+                if (++index == arguments.size())
+                    throw std::runtime_error("Missing value for " + option + ".");
+                return std::stod(arguments[index]);
+            };
+            if (option == "--threads")
+                threadCount = getValue();
+            else if (option == "--float")
+                settings.isSinglePrecision = true;
+            else if (option == "--timings")
+                StageTimings::GetInstance().reset(new StageTimings());
+            else if (option == "--lowpass" || option == "--highpass") {
+                settings.type = option.substr(2);
+                settings.cutoff = getValue();
+            }
+            else if (option == "--bandpass") {
+                settings.type = "bandpass";
+                settings.low = getValue();
+                settings.high = getValue();
+            }
+            else if (option == "--rolloff")
+                settings.rolloff = getValue();
+            else if (option == "--batch" || option == "--stream" || option == "--snr") {
+                mode = option;
+                ++index;
+                break;
+            }
+            else
+                throw std::runtime_error("Unknown option " + option + ".");
+        }
+        arguments.erase(arguments.begin(), arguments.begin() + index);
+        bool isValid = (mode.empty() && arguments.size() == 2) || (mode == "--stream" && arguments.size() <= 2)
+                       || (mode == "--batch" && arguments.size() >= 1) || (mode == "--snr" && arguments.size() == 1);
+        if (!isValid) {
+            std::cerr << "Usage: " << argv[0] << " [options] input.wav output.wav" << std::endl;
+            std::cerr << "       " << argv[0] << " [options] --batch outputDirectory input.wav..." << std::endl;
+            std::cerr << "       " << argv[0] << " [options] --stream [input.wav|- [output.wav|-]]" << std::endl;
+            std::cerr << "       " << argv[0] << " [options] --snr input.wav" << std::endl;
+            std::cerr << "Options: --threads N, --lowpass HZ, --highpass HZ, --bandpass LOW HIGH, --rolloff HZ, --float,"
+                      << " --timings" << std::endl;
+            return 1;
+        }
+        int32_t status = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (mode == "--stream") {
+            FILE* input = (arguments.size() > 0 && arguments[0] != "-" ? fopen(arguments[0].c_str(), "rb") : stdin);
+            FILE* output = (arguments.size() > 1 && arguments[1] != "-" ? fopen(arguments[1].c_str(), "wb") : stdout);
+            if (input == nullptr || output == nullptr)
+                throw std::runtime_error("Cannot open file.");
+            setvbuf(output, nullptr, _IOFBF, streamBufferSize);
+            StreamWavFile(input, output, settings);
+            fclose(input);
+            fclose(output);
+        }
+        else if (mode == "--batch") {
+            SetParallelism(threadCount);
+            std::vector<std::string> inputPaths(arguments.begin() + 1, arguments.end());
+            status = (WriteBatchOutputData(arguments[0], inputPaths, settings) == 0 ? 0 : 1);
+        }
+        else if (mode == "--snr") {
+            SetParallelism(threadCount);
+            WavReader input(arguments[0]);
+            PrintPrecisionReport(input, settings);
+        }
+        else {
+            SetParallelism(threadCount);
+            WavReader input(arguments[0]);
+            WriteOutputData(input, arguments[1], settings);
+        }
+        if (StageTimings::GetInstance()) {
+            StageTimings::GetInstance()->Print(std::cerr);
+            std::cerr << "elapsed " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+                      << " ms, peak RSS " << GetPeakResidentSize() << " kB" << std::endl;
+        }
+        return status;
+    } catch (const std::exception& exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
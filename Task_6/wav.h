@@ -0,0 +1,379 @@
+#ifndef WAV_H
+#define WAV_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../Common/simd.h"
+
+// Sample layout of a WAV stream. Samples are exchanged as doubles (or floats, in bulk) at full scale [-1, 1)
+// whatever the storage: unsigned 8-bit, signed 16/24/32-bit PCM or 32/64-bit IEEE float, any number of interleaved
+// channels.
+struct WavFormat {
+    static const uint16_t pcmFormat = 1;
+    static const uint16_t floatFormat = 3;
+    static const uint16_t extensibleFormat = 0xFFFE;
+    // Always pcmFormat or floatFormat, WAVE_FORMAT_EXTENSIBLE is resolved to its subformat.
+    uint16_t audioFormat = pcmFormat;
+    uint16_t numChannels = 1;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 16;
+    // Bytes per frame, kept to the 16 bits of the header field by GetWavFormat.
+    uint32_t GetBlockAlign() const;
+    double GetSample(const uint8_t*) const;
+    void SetSample(uint8_t*, const double&) const;
+    // Converts count samples of one channel, the first at the given address and the rest a frame apart.
+    template<typename Real>
+    void GetSamples(const uint8_t*, const uint32_t&, Real*) const;
+    template<typename Real>
+    void SetSamples(uint8_t*, const uint32_t&, const Real*) const;
+    // Mono 16-bit PCM is a plain little-endian int16 array and goes through the SIMD conversion kernels.
+    bool IsPackedInt16() const;
+};
+uint32_t WavFormat::GetBlockAlign() const {
+    return static_cast<uint32_t>(numChannels) * (bitsPerSample / 8);
+}
+double WavFormat::GetSample(const uint8_t* sample) const {
+    if (audioFormat == floatFormat) {
+        if (bitsPerSample == 32) {
+            float value;
+            memcpy(&value, sample, sizeof(value));
+            return value;
+        }
+        double value;
+        memcpy(&value, sample, sizeof(value));
+        return value;
+    }
+    switch (bitsPerSample) {
+        case 8:
+            return (sample[0] - 128) / 128.0;
+        case 16:
+            return static_cast<int16_t>(sample[0] | sample[1] << 8) / 32768.0;
+        case 24:
+            return static_cast<int32_t>(static_cast<uint32_t>(sample[0] << 8 | sample[1] << 16) | static_cast<uint32_t>(sample[2]) << 24) / 2147483648.0;
+        default:
+            return static_cast<int32_t>(static_cast<uint32_t>(sample[0] | sample[1] << 8 | sample[2] << 16) | static_cast<uint32_t>(sample[3]) << 24) / 2147483648.0;
+    }
+}
+void WavFormat::SetSample(uint8_t* sample, const double& value) const {
+    if (audioFormat == floatFormat) {
+        if (bitsPerSample == 32) {
+            float floatValue = value;
+            memcpy(sample, &floatValue, sizeof(floatValue));
+        } else {
+            memcpy(sample, &value, sizeof(value));
+        }
+        return;
+    }
+    double scale = static_cast<double>(1ULL << (bitsPerSample - 1));
+    int64_t scaled = std::max(-scale, std::min(scale - 1, std::round(value * scale)));
+    if (bitsPerSample == 16) {
+        sample[0] = static_cast<uint8_t>(scaled);
+        sample[1] = static_cast<uint8_t>(scaled >> 8);
+        return;
+    }
+    if (bitsPerSample == 8)
+        scaled += 128;
+    for (uint16_t i = 0; i < bitsPerSample / 8; ++i)
+        sample[i] = static_cast<uint8_t>(static_cast<uint64_t>(scaled) >> (8 * i));
+}
+bool WavFormat::IsPackedInt16() const {
+#ifdef SIMD_X86
+    return audioFormat == pcmFormat && bitsPerSample == 16 && numChannels == 1;
+#else
+    return false;
+#endif
+}
+template<typename Real>
+void WavFormat::GetSamples(const uint8_t* samples, const uint32_t& count, Real* output) const {
+    if (IsPackedInt16()) {
+        GetSimdKernels<Real>().fromInt16(reinterpret_cast<const int16_t*>(samples), output, count, 1 / 32768.0);
+        return;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+        output[i] = GetSample(samples + static_cast<size_t>(i) * GetBlockAlign());
+}
+template<typename Real>
+void WavFormat::SetSamples(uint8_t* samples, const uint32_t& count, const Real* input) const {
+    if (IsPackedInt16()) {
+        GetSimdKernels<Real>().toInt16(input, reinterpret_cast<int16_t*>(samples), count, 32768.0);
+        return;
+    }
+    for (uint32_t i = 0; i < count; ++i)
+        SetSample(samples + static_cast<size_t>(i) * GetBlockAlign(), input[i]);
+}
+
+uint32_t GetWavWord(const uint8_t* data) {
+    return data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+uint16_t GetWavHalfWord(const uint8_t* data) {
+    return data[0] | data[1] << 8;
+}
+void SetWavWord(uint8_t* data, const uint32_t& value) {
+    for (uint32_t i = 0; i < 4; ++i)
+        data[i] = value >> (8 * i);
+}
+void SetWavHalfWord(uint8_t* data, const uint16_t& value) {
+    data[0] = value;
+    data[1] = value >> 8;
+}
+
+// Decodes the body of a "fmt " chunk.
+WavFormat GetWavFormat(const uint8_t* chunk, const uint32_t& chunkSize) {
+    if (chunkSize < 16)
+        throw std::runtime_error("WAV fmt chunk is too short.");
+    WavFormat format;
+    format.audioFormat = GetWavHalfWord(chunk);
+    format.numChannels = GetWavHalfWord(chunk + 2);
+    format.sampleRate = GetWavWord(chunk + 4);
+    format.bitsPerSample = GetWavHalfWord(chunk + 14);
+    // WAVE_FORMAT_EXTENSIBLE: cbSize, valid bits, channel mask, then a GUID whose first two bytes are the format tag.
+    if (format.audioFormat == WavFormat::extensibleFormat) {
+        if (chunkSize < 40)
+            throw std::runtime_error("WAV extensible fmt chunk is too short.");
+        format.audioFormat = GetWavHalfWord(chunk + 24);
+    }
+    bool isPCM = format.audioFormat == WavFormat::pcmFormat && (format.bitsPerSample == 8 || format.bitsPerSample == 16 || format.bitsPerSample == 24 || format.bitsPerSample == 32);
+    bool isFloat = format.audioFormat == WavFormat::floatFormat && (format.bitsPerSample == 32 || format.bitsPerSample == 64);
+    if (!isPCM && !isFloat)
+        throw std::runtime_error("Unsupported WAV sample format.");
+    if (format.numChannels == 0)
+        throw std::runtime_error("WAV file has no channels.");
+    if (format.GetBlockAlign() > UINT16_MAX)
+        throw std::runtime_error("WAV frame size does not fit in 16 bits.");
+    return format;
+}
+
+// Canonical 44-byte header of a file holding dataSize bytes of samples.
+std::vector<uint8_t> GetWavHeader(const WavFormat& format, const uint32_t& dataSize) {
+    std::vector<uint8_t> header(44);
+    memcpy(header.data(), "RIFF", 4);
+    SetWavWord(header.data() + 4, 36 + dataSize + dataSize % 2);
+    memcpy(header.data() + 8, "WAVEfmt ", 8);
+    SetWavWord(header.data() + 16, 16);
+    SetWavHalfWord(header.data() + 20, format.audioFormat);
+    SetWavHalfWord(header.data() + 22, format.numChannels);
+    SetWavWord(header.data() + 24, format.sampleRate);
+    SetWavWord(header.data() + 28, format.sampleRate * format.GetBlockAlign());
+    SetWavHalfWord(header.data() + 32, format.GetBlockAlign());
+    SetWavHalfWord(header.data() + 34, format.bitsPerSample);
+    memcpy(header.data() + 36, "data", 4);
+    SetWavWord(header.data() + 40, dataSize);
+    return header;
+}
+
+// Reads the RIFF header and the chunks up to "data" from a stream that cannot seek, such as stdin. Returns the
+// format and leaves the stream at the first sample; dataSize receives the size declared by the data chunk.
+WavFormat ReadWavHeader(FILE* input, uint32_t& dataSize) {
+    uint8_t header[12];
+    if (fread(header, 1, 12, input) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        throw std::runtime_error("Not a RIFF/WAVE stream.");
+    bool hasFormat = false;
+    WavFormat format;
+    std::vector<uint8_t> chunk;
+    while (true) {
+        if (fread(header, 1, 8, input) != 8)
+            throw std::runtime_error("WAV stream has no data chunk.");
+        uint32_t chunkSize = GetWavWord(header + 4);
+        if (memcmp(header, "data", 4) == 0) {
+            if (!hasFormat)
+                throw std::runtime_error("WAV data chunk precedes fmt chunk.");
+            dataSize = chunkSize;
+            return format;
+        }
+        chunk.resize(chunkSize + chunkSize % 2);
+        if (fread(chunk.data(), 1, chunk.size(), input) != chunk.size())
+            throw std::runtime_error("WAV stream is truncated.");
+        if (memcmp(header, "fmt ", 4) == 0) {
+            format = GetWavFormat(chunk.data(), chunkSize);
+            hasFormat = true;
+        }
+    }
+}
+
+// One channel of an interleaved sample buffer, read in place.
+class WavChannelView {
+    public:
+        WavChannelView(const uint8_t*, const WavFormat&, const uint16_t&, const uint32_t&);
+        uint32_t GetSize() const;
+        double operator[](const uint32_t&) const;
+        // Converts the whole channel into output, which must hold GetSize() values.
+        template<typename Real>
+        void Read(Real*) const;
+    private:
+        const uint8_t* data;
+        WavFormat format;
+        uint32_t stride;
+        uint32_t size;
+};
+WavChannelView::WavChannelView(const uint8_t* data, const WavFormat& format, const uint16_t& channel, const uint32_t& size)
+    : data(data + channel * (format.bitsPerSample / 8)), format(format), stride(format.GetBlockAlign()), size(size) {}
+uint32_t WavChannelView::GetSize() const {
+    return size;
+}
+double WavChannelView::operator[](const uint32_t& index) const {
+    return format.GetSample(data + static_cast<size_t>(index) * stride);
+}
+template<typename Real>
+void WavChannelView::Read(Real* output) const {
+    format.GetSamples(data, size, output);
+}
+
+// Memory-mapped WAV file. Unknown chunks (LIST, fact, ...) are skipped; a data chunk that claims more bytes than
+// the file holds, as written by recorders that never patch the header, is cut to what is there.
+class WavReader {
+    public:
+        explicit WavReader(const std::string&);
+        WavReader(const WavReader&) = delete;
+        WavReader& operator=(const WavReader&) = delete;
+        ~WavReader();
+        const WavFormat& GetFormat() const;
+        uint32_t GetFrameCount() const;
+        WavChannelView GetChannel(const uint16_t&) const;
+    private:
+        int fileDescriptor = -1;
+        uint8_t* mapping = nullptr;
+        size_t mappingSize = 0;
+        WavFormat format;
+        const uint8_t* samples = nullptr;
+        uint32_t frameCount = 0;
+        void Close();
+};
+WavReader::WavReader(const std::string& path) {
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    struct stat fileStat;
+    if (fileDescriptor < 0 || fstat(fileDescriptor, &fileStat) != 0) {
+        Close();
+        throw std::runtime_error("Cannot open " + path + ".");
+    }
+    mappingSize = fileStat.st_size;
+    if (mappingSize > 0) {
+        void* address = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (address == MAP_FAILED) {
+            Close();
+            throw std::runtime_error("Cannot map " + path + ".");
+        }
+        mapping = static_cast<uint8_t*>(address);
+        madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+    }
+    if (mappingSize < 12 || memcmp(mapping, "RIFF", 4) != 0 || memcmp(mapping + 8, "WAVE", 4) != 0) {
+        Close();
+        throw std::runtime_error(path + " is not a RIFF/WAVE file.");
+    }
+    bool hasFormat = false;
+    size_t position = 12;
+    while (samples == nullptr) {
+        if (position + 8 > mappingSize) {
+            Close();
+            throw std::runtime_error(path + " has no data chunk.");
+        }
+        const uint8_t* chunk = mapping + position;
+        size_t chunkSize = std::min<size_t>(GetWavWord(chunk + 4), mappingSize - position - 8);
+        if (memcmp(chunk, "fmt ", 4) == 0) {
+            try {
+                format = GetWavFormat(chunk + 8, chunkSize);
+            } catch (...) {
+                Close();
+                throw;
+            }
+            hasFormat = true;
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (!hasFormat) {
+                Close();
+                throw std::runtime_error(path + " has a data chunk before its fmt chunk.");
+            }
+            samples = chunk + 8;
+            frameCount = chunkSize / format.GetBlockAlign();
+        }
+        position += 8 + chunkSize + chunkSize % 2;
+    }
+}
+WavReader::~WavReader() {
+    Close();
+}
+void WavReader::Close() {
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+    if (fileDescriptor >= 0)
+        close(fileDescriptor);
+    mapping = nullptr;
+    fileDescriptor = -1;
+}
+const WavFormat& WavReader::GetFormat() const {
+    return format;
+}
+uint32_t WavReader::GetFrameCount() const {
+    return frameCount;
+}
+WavChannelView WavReader::GetChannel(const uint16_t& channel) const {
+    return WavChannelView(samples, format, channel, frameCount);
+}
+
+// Output file of a known size, created at full length and written through a shared mapping.
+class WavWriter {
+    public:
+        WavWriter(const std::string&, const WavFormat&, const uint32_t&);
+        WavWriter(const WavWriter&) = delete;
+        WavWriter& operator=(const WavWriter&) = delete;
+        ~WavWriter();
+        void SetSample(const uint32_t&, const uint16_t&, const double&);
+        // Writes count samples of one channel starting at frame 0.
+        template<typename Real>
+        void SetChannel(const uint16_t&, const Real*, const uint32_t&);
+    private:
+        int fileDescriptor = -1;
+        uint8_t* mapping = nullptr;
+        size_t mappingSize = 0;
+        WavFormat format;
+        uint8_t* samples = nullptr;
+        void Close();
+};
+WavWriter::WavWriter(const std::string& path, const WavFormat& format, const uint32_t& frameCount) : format(format) {
+    uint64_t dataSize = static_cast<uint64_t>(frameCount) * format.GetBlockAlign();
+    if (dataSize > UINT32_MAX - 36)
+        throw std::runtime_error("WAV output is too large.");
+    std::vector<uint8_t> header = GetWavHeader(format, dataSize);
+    mappingSize = header.size() + dataSize + dataSize % 2;
+    fileDescriptor = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0 || ftruncate(fileDescriptor, mappingSize) != 0) {
+        Close();
+        throw std::runtime_error("Cannot create " + path + ".");
+    }
+    void* address = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        Close();
+        throw std::runtime_error("Cannot map " + path + ".");
+    }
+    mapping = static_cast<uint8_t*>(address);
+    memcpy(mapping, header.data(), header.size());
+    samples = mapping + header.size();
+}
+WavWriter::~WavWriter() {
+    Close();
+}
+void WavWriter::Close() {
+    if (mapping != nullptr)
+        munmap(mapping, mappingSize);
+    if (fileDescriptor >= 0)
+        close(fileDescriptor);
+    mapping = nullptr;
+    fileDescriptor = -1;
+}
+void WavWriter::SetSample(const uint32_t& frame, const uint16_t& channel, const double& value) {
+    format.SetSample(samples + static_cast<size_t>(frame) * format.GetBlockAlign() + channel * (format.bitsPerSample / 8), value);
+}
+template<typename Real>
+void WavWriter::SetChannel(const uint16_t& channel, const Real* values, const uint32_t& count) {
+    format.SetSamples(samples + channel * (format.bitsPerSample / 8), count, values);
+}
+
+#endif